@@ -0,0 +1,47 @@
+#include "arena.h"
+
+void arena_init(Arena *a, void *buf, size_t cap)
+{
+    uintptr_t addr = (uintptr_t)buf;
+    size_t skip = (size_t)(ARENA_ROUND(addr) - addr);
+
+    a->base = (uint8_t *)buf;
+    a->cap = 0;
+    if (buf != NULL && skip <= cap) {
+        a->base += skip;
+        a->cap = cap - skip;
+    }
+    a->used = 0;
+    a->high_water = 0;
+}
+
+void *arena_alloc(Arena *a, size_t size)
+{
+    size_t rounded = ARENA_ROUND(size);
+    if (rounded < size || rounded > a->cap - a->used) return NULL;
+
+    void *p = a->base + a->used;
+    a->used += rounded;
+    if (a->used > a->high_water) a->high_water = a->used;
+    return p;
+}
+
+size_t arena_mark(const Arena *a)
+{
+    return a->used;
+}
+
+void arena_release(Arena *a, size_t mark)
+{
+    if (mark < a->used) a->used = mark;
+}
+
+void arena_reset(Arena *a)
+{
+    a->used = 0;
+}
+
+size_t arena_high_water(const Arena *a)
+{
+    return a->high_water;
+}
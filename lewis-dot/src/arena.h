@@ -0,0 +1,39 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Bump allocator over a caller-supplied buffer for per-step solver and
+ * layout scratch. Allocation moves a cursor; a step takes a mark on entry
+ * and releases back to it on exit, so nothing is freed one by one and
+ * nothing touches the heap. high_water records the deepest use since
+ * init, across resets, so a batch can size its buffer from real runs.
+ */
+#define ARENA_ALIGN 4u /* int32_t, the widest scratch element */
+#define ARENA_ROUND(n) (((size_t)(n) + ARENA_ALIGN - 1u) & ~(size_t)(ARENA_ALIGN - 1u))
+
+typedef struct {
+    uint8_t *base;
+    size_t cap;
+    size_t used;
+    size_t high_water;
+} Arena;
+
+/* Empty arena over buf; the first bytes may go to alignment. */
+void arena_init(Arena *a, void *buf, size_t cap);
+
+/* size bytes aligned to ARENA_ALIGN, or NULL (and no change) when they do not fit. */
+void *arena_alloc(Arena *a, size_t size);
+
+/* Position to release back to; everything allocated after it goes at once. */
+size_t arena_mark(const Arena *a);
+void arena_release(Arena *a, size_t mark);
+
+/* Release everything; high_water is kept. */
+void arena_reset(Arena *a);
+
+size_t arena_high_water(const Arena *a);
+
+#endif
@@ -0,0 +1,31 @@
+#include "cache_appvar.h"
+
+#include <fileioc.h>
+
+static bool appvar_load(void *ctx, uint8_t *buf, size_t cap, size_t *len)
+{
+    (void)ctx;
+    uint8_t h = ti_Open(CACHE_APPVAR_NAME, "r");
+    if (h == 0) return false;
+
+    size_t size = ti_GetSize(h);
+    bool ok = size <= cap && ti_Read(buf, 1, size, h) == size;
+    ti_Close(h);
+    if (ok) *len = size;
+    return ok;
+}
+
+static bool appvar_save(void *ctx, const uint8_t *buf, size_t len)
+{
+    (void)ctx;
+    uint8_t h = ti_Open(CACHE_APPVAR_NAME, "w");
+    if (h == 0) return false;
+
+    bool ok = ti_Write(buf, 1, len, h) == len;
+    if (ok) ok = ti_SetArchiveStatus(true, h) != 0;
+    ti_Close(h);
+    if (!ok) ti_Delete(CACHE_APPVAR_NAME);
+    return ok;
+}
+
+const ResultCacheStore cache_appvar_store = { appvar_load, appvar_save, NULL };
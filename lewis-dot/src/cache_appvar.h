@@ -0,0 +1,15 @@
+#ifndef CACHE_APPVAR_H
+#define CACHE_APPVAR_H
+
+#include "result_cache.h"
+
+/*
+ * ResultCacheStore backed by the CACHE_APPVAR_NAME AppVar through fileioc.
+ * The AppVar is archived after each save so the cache survives RAM resets
+ * and later launches.
+ */
+#define CACHE_APPVAR_NAME "LEWISRC"
+
+extern const ResultCacheStore cache_appvar_store;
+
+#endif
@@ -0,0 +1,122 @@
+#include "display_list.h"
+
+#include <string.h>
+
+/* Formal charges stay within a few units; "+2", "-1" and the like. */
+static void format_charge(int8_t fc, char *buf)
+{
+    uint8_t mag = (uint8_t)((fc < 0) ? -fc : fc);
+    uint8_t n = 0;
+
+    buf[n++] = (fc < 0) ? '-' : '+';
+    if (mag >= 10) buf[n++] = (char)('0' + (mag / 10u) % 10u);
+    buf[n++] = (char)('0' + mag % 10u);
+    buf[n] = '\0';
+}
+
+static DlBox box_around(int x1, int y1, int x2, int y2, int pad)
+{
+    int min_x = (x1 < x2) ? x1 : x2;
+    int max_x = (x1 > x2) ? x1 : x2;
+    int min_y = (y1 < y2) ? y1 : y2;
+    int max_y = (y1 > y2) ? y1 : y2;
+
+    DlBox b;
+    b.x = (int16_t)(min_x - pad);
+    b.y = (int16_t)(min_y - pad);
+    b.w = (int16_t)((max_x - min_x) + 1 + (pad * 2));
+    b.h = (int16_t)((max_y - min_y) + 1 + (pad * 2));
+    return b;
+}
+
+static DlPrim *push(DisplayList *dl, uint8_t kind, uint8_t atom)
+{
+    if (dl->count >= DL_MAX_PRIMS) return NULL;
+
+    DlPrim *p = &dl->prims[dl->count++];
+    memset(p, 0, sizeof(*p));
+    p->kind = kind;
+    p->atom = atom;
+    return p;
+}
+
+void display_list_build(const Molecule *mol, const LewisStructure *ls, const AtomLayout *lay, DisplayList *dl)
+{
+    dl->count = 0;
+
+    for (uint8_t b = 0; b < ls->num_bonds; b++) {
+        uint8_t a = ls->bonds[b].a;
+        uint8_t c = ls->bonds[b].b;
+        DlPrim *p = push(dl, DL_BOND, b);
+        if (p == NULL) return;
+
+        p->order = ls->bonds[b].order;
+        p->x1 = lay->x[a];
+        p->y1 = lay->y[a];
+        p->x2 = lay->x[c];
+        p->y2 = lay->y[c];
+        if (a == mol->central || c == mol->central) p->flags = DL_FLAG_CENTRAL;
+
+        if (p->order >= 2) {
+            int ox;
+            int oy;
+            layout_bond_offset(p->x2 - p->x1, p->y2 - p->y1, (p->order == 2) ? 3 : 4, &ox, &oy);
+            p->ox = (int8_t)ox;
+            p->oy = (int8_t)oy;
+        }
+        p->box = box_around(p->x1, p->y1, p->x2, p->y2, 2);
+    }
+
+    for (uint8_t i = 0; i < mol->num_atoms; i++) {
+        const char *sym = elements[mol->atoms[i].elem].symbol;
+        int len = (int)strlen(sym);
+        uint8_t flags = (i == mol->central) ? DL_FLAG_CENTRAL : 0;
+
+        DlPrim *p = push(dl, DL_SYMBOL, i);
+        if (p == NULL) return;
+        p->flags = flags;
+        p->x1 = (int16_t)(lay->x[i] - len * 4);
+        p->y1 = (int16_t)(lay->y[i] - 4);
+        memcpy(p->text, sym, (size_t)len + 1);
+        p->box.x = (int16_t)(p->x1 - 1);
+        p->box.y = (int16_t)(p->y1 - 1);
+        p->box.w = (int16_t)(len * 8 + 2);
+        p->box.h = 10;
+
+        for (uint8_t lp = 0; lp < ls->lone_pairs[i] && lp < LP_MAX_SLOTS; lp++) {
+            int dots[4];
+            layout_lone_pair_dots(lay, i, lp, dots);
+
+            p = push(dl, DL_DOTS, i);
+            if (p == NULL) return;
+            p->flags = flags;
+            p->x1 = (int16_t)dots[0];
+            p->y1 = (int16_t)dots[1];
+            p->x2 = (int16_t)dots[2];
+            p->y2 = (int16_t)dots[3];
+            p->box = box_around(dots[0], dots[1], dots[2], dots[3], DOT_R);
+        }
+
+        if (ls->formal_charge[i] != 0) {
+            p = push(dl, DL_CHARGE, i);
+            if (p == NULL) return;
+            p->flags = flags;
+            format_charge(ls->formal_charge[i], p->text);
+            p->x1 = (int16_t)(lay->x[i] + len * 4 + 2);
+            p->y1 = (int16_t)(lay->y[i] - 12);
+            p->box.x = p->x1;
+            p->box.y = p->y1;
+            p->box.w = (int16_t)(strlen(p->text) * 8);
+            p->box.h = 8;
+        }
+    }
+}
+
+bool display_list_add_card(DisplayList *dl, const DlBox *card)
+{
+    DlPrim *p = push(dl, DL_CARD, 0);
+    if (p == NULL) return false;
+
+    p->box = *card;
+    return true;
+}
@@ -0,0 +1,65 @@
+#ifndef DISPLAY_LIST_H
+#define DISPLAY_LIST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "layout.h"
+#include "lewis_model.h"
+
+/*
+ * Retained display list for one resonance form: every primitive of the
+ * Lewis screen with its final screen coordinates and bounding box. It is
+ * built once per form change; the renderer, the VSEPR card placement and
+ * host exporters all walk the same list.
+ */
+typedef enum {
+    DL_BOND,    /* (x1,y1)-(x2,y2), order strokes offset by (ox,oy) */
+    DL_DOTS,    /* one lone pair: dots at (x1,y1) and (x2,y2) */
+    DL_SYMBOL,  /* element symbol text at (x1,y1) */
+    DL_CHARGE,  /* formal-charge label text at (x1,y1) */
+    DL_CARD     /* VSEPR info card occupying box */
+} DlKind;
+
+/* DlPrim.flags */
+#define DL_FLAG_CENTRAL 0x01  /* bond touches, or item belongs to, the central atom */
+
+#define DL_TEXT_MAX 5
+
+typedef struct {
+    int16_t x;
+    int16_t y;
+    int16_t w;
+    int16_t h;
+} DlBox;
+
+typedef struct {
+    uint8_t kind;
+    uint8_t flags;
+    uint8_t atom;   /* owning atom; bond index for DL_BOND */
+    uint8_t order;  /* bond order for DL_BOND */
+    int16_t x1;
+    int16_t y1;
+    int16_t x2;
+    int16_t y2;
+    int8_t ox;
+    int8_t oy;
+    char text[DL_TEXT_MAX];
+    DlBox box;
+} DlPrim;
+
+/* Bonds, then per atom a symbol, up to LP_MAX_SLOTS pairs and a charge, then the card. */
+#define DL_MAX_PRIMS (MAX_BONDS + MAX_ATOMS * (2 + LP_MAX_SLOTS) + 1)
+
+typedef struct {
+    DlPrim prims[DL_MAX_PRIMS];
+    uint8_t count;
+} DisplayList;
+
+/* Rebuild dl from one resonance form and its layout. */
+void display_list_build(const Molecule *mol, const LewisStructure *ls, const AtomLayout *lay, DisplayList *dl);
+
+/* Append the VSEPR card as the topmost primitive. Returns false when full. */
+bool display_list_add_card(DisplayList *dl, const DlBox *card);
+
+#endif
@@ -0,0 +1,102 @@
+#include "fixed_math.h"
+
+#ifdef LEWIS_OP_COUNT
+FxOpCounts fx_ops;
+#endif
+
+/* round(32768 / n) for n = 1..FX_RECIP_MAX; entry 0 is unused. */
+const uint16_t fx_recip_q15[FX_RECIP_MAX + 1] = {
+        0, 32768, 16384, 10923,  8192,  6554,  5461,  4681,
+     4096,  3641,  3277,  2979,  2731,  2521,  2341,  2185,
+     2048,  1928,  1820,  1725,  1638,  1560,  1489,  1425,
+     1365,  1311,  1260,  1214,  1170,  1130,  1092,  1057,
+     1024,   993,   964,   936,   910,   886,   862,   840,
+      819,   799,   780,   762,   745,   728,   712,   697,
+      683,   669,   655,   643,   630,   618,   607,   596,
+      585,   575,   565,   555,   546,   537,   529,   520,
+      512,   504,   496,   489,   482,   475,   468,   462,
+      455,   449,   443,   437,   431,   426,   420,   415,
+      410,   405,   400,   395,   390,   386,   381,   377,
+      372,   368,   364,   360,   356,   352,   349,   345,
+      341,   338,   334,   331,   328,   324,   321,   318,
+      315,   312,   309,   306,   303,   301,   298,   295,
+      293,   290,   287,   285,   282,   280,   278,   275,
+      273,   271,   269,   266,   264,   262,   260,   258,
+      256,   254,   252,   250,   248,   246,   245,   243,
+      241,   239,   237,   236,   234,   232,   231,   229,
+      228,   226,   224,   223,   221,   220,   218,   217,
+      216,   214,   213,   211,   210,   209,   207,   206,
+      205,   204,   202,   201,   200,   199,   197,   196,
+      195,   194,   193,   192,   191,   189,   188,   187,
+      186,   185,   184,   183,   182,   181,   180,   179,
+      178,   177,   176,   175,   174,   173,   172,   172,
+      171,   170,   169,   168,   167,   166,   165,   165,
+      164,   163,   162,   161,   161,   160,   159,   158,
+      158,   157,   156,   155,   155,   154,   153,   152,
+      152,   151,   150,   150,   149,   148,   148,   147,
+      146,   146,   145,   144,   144,   143,   142,   142,
+      141,   141,   140,   139,   139,   138,   138,   137,
+      137,   136,   135,   135,   134,   134,   133,   133,
+      132,   132,   131,   131,   130,   130,   129,   129,
+      128
+};
+
+/* Reduce den into table range; every halving of den adds one to the final shift. */
+static uint16_t recip_for(unsigned int den, uint8_t *shift)
+{
+    *shift = 15;
+    while (den > FX_RECIP_MAX) {
+        den >>= 1;
+        (*shift)++;
+    }
+    FX_COUNT(recips);
+    return fx_recip_q15[den];
+}
+
+int fx_muldiv(int v, int num, unsigned int den)
+{
+    if (den == 0) return 0;
+
+    uint8_t shift;
+    uint16_t r = recip_for(den, &shift);
+    int32_t p = (int32_t)v * num;
+    bool neg = p < 0;
+    if (neg) p = -p;
+
+    FX_COUNT(muls);
+    uint32_t q = ((uint32_t)p * r + ((uint32_t)1 << (shift - 1))) >> shift;
+    return neg ? -(int)q : (int)q;
+}
+
+unsigned int fx_udiv(unsigned int num, unsigned int den)
+{
+    if (den == 0) return 0;
+
+    uint8_t shift;
+    uint16_t r = recip_for(den, &shift);
+    FX_COUNT(muls);
+    uint32_t q = ((uint32_t)num * r) >> shift;
+
+    /* The Q15 reciprocal is rounded, so the estimate can be off by one either way. */
+    while (q * den > num) q--;
+    while ((q + 1) * den <= num) q++;
+    return (unsigned int)q;
+}
+
+uint16_t fx_isqrt32(uint32_t v)
+{
+    uint32_t root = 0;
+    uint32_t bit = (uint32_t)1 << 30;
+
+    while (bit > v) bit >>= 2;
+    while (bit != 0) {
+        if (v >= root + bit) {
+            v -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint16_t)root;
+}
@@ -0,0 +1,40 @@
+#ifndef FIXED_MATH_H
+#define FIXED_MATH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Divide helpers for the eZ80, which has no hardware divide. Quotients
+ * come from a Q15 reciprocal table, one multiply and shifts instead of the
+ * runtime divide routine. They still cost a lookup and a multiply per
+ * quotient: a few per multiple bond when the display list is built, and
+ * many more in the once-per-solve stress layout (see tools/op_count.c).
+ */
+#define FX_RECIP_MAX 256
+
+extern const uint16_t fx_recip_q15[FX_RECIP_MAX + 1];
+
+/* v * num / den, rounded to nearest (symmetric for negative v). */
+int fx_muldiv(int v, int num, unsigned int den);
+
+/* Exact truncating num / den for the small operands layout uses. */
+unsigned int fx_udiv(unsigned int num, unsigned int den);
+
+/* floor(sqrt(v)), bit by bit with shifts and adds only. */
+uint16_t fx_isqrt32(uint32_t v);
+
+/* Host-side operation counters (build with -DLEWIS_OP_COUNT). */
+#ifdef LEWIS_OP_COUNT
+typedef struct {
+    uint32_t recips; /* reciprocal table lookups */
+    uint32_t muls;   /* multiplies issued by the fixed-point helpers */
+} FxOpCounts;
+
+extern FxOpCounts fx_ops;
+#define FX_COUNT(field) (fx_ops.field++)
+#else
+#define FX_COUNT(field) ((void)0)
+#endif
+
+#endif
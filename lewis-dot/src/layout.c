@@ -3,19 +3,36 @@
 #include <stdlib.h>
 #include <string.h>
 
-/* sin/cos lookup table (fixed-point, 8-bit fraction) for 12 radial positions. */
-static const int16_t cos_tbl[12] = {
-     256,  222,  128,    0, -128, -222,
-    -256, -222, -128,    0,  128,  222
+#include "fixed_math.h"
+
+/*
+ * Bond-length offsets for 24 radial directions, 15 degrees apart (0 right,
+ * 6 down, 12 left, 18 up): cos/sin in 8-bit fixed point scaled by
+ * BOND_LEN and rounded. FX_BOND folds at compile time, so placing an atom
+ * on a direction costs two table reads and no multiply or divide.
+ */
+#define FX_BOND(v) ((int8_t)(((v) * BOND_LEN + ((v) < 0 ? -128 : 128)) / 256))
+#define LAYOUT_DIRS 24
+
+static const int8_t bond_dx[LAYOUT_DIRS] = {
+    FX_BOND(256),  FX_BOND(247),  FX_BOND(222),  FX_BOND(181),  FX_BOND(128),  FX_BOND(66),
+    FX_BOND(0),    FX_BOND(-66),  FX_BOND(-128), FX_BOND(-181), FX_BOND(-222), FX_BOND(-247),
+    FX_BOND(-256), FX_BOND(-247), FX_BOND(-222), FX_BOND(-181), FX_BOND(-128), FX_BOND(-66),
+    FX_BOND(0),    FX_BOND(66),   FX_BOND(128),  FX_BOND(181),  FX_BOND(222),  FX_BOND(247)
 };
 
-static const int16_t sin_tbl[12] = {
-       0,  128,  222,  256,  222,  128,
-       0, -128, -222, -256, -222, -128
+static const int8_t bond_dy[LAYOUT_DIRS] = {
+    FX_BOND(0),    FX_BOND(66),   FX_BOND(128),  FX_BOND(181),  FX_BOND(222),  FX_BOND(247),
+    FX_BOND(256),  FX_BOND(247),  FX_BOND(222),  FX_BOND(181),  FX_BOND(128),  FX_BOND(66),
+    FX_BOND(0),    FX_BOND(-66),  FX_BOND(-128), FX_BOND(-181), FX_BOND(-222), FX_BOND(-247),
+    FX_BOND(-256), FX_BOND(-247), FX_BOND(-222), FX_BOND(-181), FX_BOND(-128), FX_BOND(-66)
 };
 
+/* Even spacing uses every other direction: 12 positions, 30 degrees apart. */
+#define EVEN_DIR(k) ((k) << 1)
+
 /* Layout helper: render path-like molecules in a straight horizontal line. */
-bool layout_linear_chain(const Molecule *mol, const LewisStructure *ls, int ax[MAX_ATOMS], int ay[MAX_ATOMS])
+bool layout_linear_chain(const Molecule *mol, const LewisStructure *ls, AtomLayout *out)
 {
     if (mol->num_atoms < 3) return false;
     if (ls->num_bonds != mol->num_atoms - 1) return false;
@@ -64,22 +81,22 @@ bool layout_linear_chain(const Molecule *mol, const LewisStructure *ls, int ax[M
         if (k + 1 < mol->num_atoms && cur < 0) return false;
     }
 
-    int step = (SCR_W - 80) / (mol->num_atoms - 1);
+    int step = (int)fx_udiv(SCR_W - 80, mol->num_atoms - 1);
     if (step > BOND_LEN) step = BOND_LEN;
     if (step < 22) step = 22;
     int total_w = step * (mol->num_atoms - 1);
-    int x0 = LEWIS_CENTER_X - total_w / 2;
+    int x0 = LEWIS_CENTER_X - (total_w >> 1);
 
     for (uint8_t k = 0; k < mol->num_atoms; k++) {
         uint8_t idx = order[k];
-        ax[idx] = x0 + k * step;
-        ay[idx] = LEWIS_CENTER_Y;
+        out->x[idx] = (int16_t)(x0 + k * step);
+        out->y[idx] = LEWIS_CENTER_Y;
     }
     return true;
 }
 
 /* Layout helper: place atoms by graph distance from central atom. */
-bool layout_tree_from_central(const Molecule *mol, const LewisStructure *ls, int ax[MAX_ATOMS], int ay[MAX_ATOMS])
+bool layout_tree_from_central(const Molecule *mol, const LewisStructure *ls, AtomLayout *out)
 {
     if (mol->num_atoms == 0) return false;
 
@@ -117,8 +134,8 @@ bool layout_tree_from_central(const Molecule *mol, const LewisStructure *ls, int
         if (dist[i] > max_dist) max_dist = dist[i];
     }
 
-    ax[mol->central] = LEWIS_CENTER_X;
-    ay[mol->central] = LEWIS_CENTER_Y;
+    out->x[mol->central] = LEWIS_CENTER_X;
+    out->y[mol->central] = LEWIS_CENTER_Y;
 
     /* First shell around central */
     uint8_t first[MAX_ATOMS];
@@ -127,10 +144,10 @@ bool layout_tree_from_central(const Molecule *mol, const LewisStructure *ls, int
         if (dist[i] == 1) first[n_first++] = i;
     }
     for (uint8_t k = 0; k < n_first; k++) {
-        int angle_idx = (k * 12) / (n_first ? n_first : 1);
+        int angle_idx = (int)fx_udiv(k * 12u, n_first ? n_first : 1);
         uint8_t node = first[k];
-        ax[node] = LEWIS_CENTER_X + (int)(cos_tbl[angle_idx] * BOND_LEN / 256);
-        ay[node] = LEWIS_CENTER_Y + (int)(sin_tbl[angle_idx] * BOND_LEN / 256);
+        out->x[node] = (int16_t)(LEWIS_CENTER_X + bond_dx[EVEN_DIR(angle_idx)]);
+        out->y[node] = (int16_t)(LEWIS_CENTER_Y + bond_dy[EVEN_DIR(angle_idx)]);
     }
 
     /* Outer shells extend away from central, with slight sibling spreading. */
@@ -140,15 +157,15 @@ bool layout_tree_from_central(const Molecule *mol, const LewisStructure *ls, int
             int p = parent[i];
             if (p < 0) return false;
 
-            int dx = ax[p] - LEWIS_CENTER_X;
-            int dy = ay[p] - LEWIS_CENTER_Y;
+            int dx = out->x[p] - LEWIS_CENTER_X;
+            int dy = out->y[p] - LEWIS_CENTER_Y;
             if (dx == 0 && dy == 0) dx = 1;
 
             int len = abs(dx) > abs(dy) ? abs(dx) : abs(dy);
             if (len == 0) len = 1;
 
-            int bx = ax[p] + dx * BOND_LEN / len;
-            int by = ay[p] + dy * BOND_LEN / len;
+            int bx = out->x[p] + fx_muldiv(dx, BOND_LEN, (unsigned int)len);
+            int by = out->y[p] + fx_muldiv(dy, BOND_LEN, (unsigned int)len);
 
             int sib_count = 0;
             int sib_idx = 0;
@@ -165,14 +182,691 @@ bool layout_tree_from_central(const Molecule *mol, const LewisStructure *ls, int
                 int plen = abs(pdx) > abs(pdy) ? abs(pdx) : abs(pdy);
                 if (plen == 0) plen = 1;
                 int spread = (sib_idx * 2 - (sib_count - 1)) * 8;
-                bx += pdx * spread / plen;
-                by += pdy * spread / plen;
+                bx += fx_muldiv(pdx, spread, (unsigned int)plen);
+                by += fx_muldiv(pdy, spread, (unsigned int)plen);
             }
 
-            ax[i] = bx;
-            ay[i] = by;
+            out->x[i] = (int16_t)bx;
+            out->y[i] = (int16_t)by;
+        }
+    }
+
+    return true;
+}
+
+/* Fallback: simple radial arrangement around central. */
+void layout_radial(const Molecule *mol, AtomLayout *out)
+{
+    out->x[mol->central] = LEWIS_CENTER_X;
+    out->y[mol->central] = LEWIS_CENTER_Y;
+
+    int n_term = mol->num_atoms - 1;
+    int term_idx = 0;
+    for (uint8_t i = 0; i < mol->num_atoms; i++) {
+        if (i == mol->central) continue;
+        int angle_idx = term_idx;
+        if (n_term <= 12) {
+            angle_idx = (int)fx_udiv(term_idx * 12u, (unsigned int)n_term);
+        } else {
+            while (angle_idx >= 12) angle_idx -= 12;
+        }
+        out->x[i] = (int16_t)(LEWIS_CENTER_X + bond_dx[EVEN_DIR(angle_idx)]);
+        out->y[i] = (int16_t)(LEWIS_CENTER_Y + bond_dy[EVEN_DIR(angle_idx)]);
+        term_idx++;
+    }
+}
+
+/*
+ * 2D projections of the VSEPR classes, keyed by bonding and lone pairs on
+ * the central atom: one direction per bonded neighbour, and the order in
+ * which the central atom's lone pairs take the four dot slots. The bond
+ * directions leave the first-ranked slots clear, so lone pairs sit where
+ * the missing domains would be (above a bent or pyramidal centre, beside a
+ * seesaw or T-shape, below a square pyramid).
+ */
+#define LP_ORDER(a, b, c, d) ((uint8_t)((a) | ((b) << 2) | ((c) << 4) | ((d) << 6)))
+#define LP_ORDER_UDLR LP_ORDER(LP_SLOT_UP, LP_SLOT_DOWN, LP_SLOT_LEFT, LP_SLOT_RIGHT)
+#define LP_ORDER_LUDR LP_ORDER(LP_SLOT_LEFT, LP_SLOT_UP, LP_SLOT_DOWN, LP_SLOT_RIGHT)
+#define LP_ORDER_LRUD LP_ORDER(LP_SLOT_LEFT, LP_SLOT_RIGHT, LP_SLOT_UP, LP_SLOT_DOWN)
+#define LP_ORDER_DULR LP_ORDER(LP_SLOT_DOWN, LP_SLOT_UP, LP_SLOT_LEFT, LP_SLOT_RIGHT)
+#define VSEPR_MAX_BONDS 7
+
+typedef struct {
+    uint8_t bond_pairs;
+    uint8_t lone_pairs;
+    uint8_t lp_order;   /* packed like AtomLayout.lp_slots */
+    uint8_t dirs[VSEPR_MAX_BONDS];
+} VseprProjection;
+
+static const VseprProjection vsepr_projections[] = {
+    {2, 0, LP_ORDER_UDLR, {0, 12}},                   /* linear */
+    {2, 1, LP_ORDER_UDLR, {2, 10}},                   /* bent, 120 */
+    {2, 2, LP_ORDER_UDLR, {2, 10}},                   /* bent */
+    {2, 3, LP_ORDER_UDLR, {0, 12}},                   /* linear */
+    {2, 4, LP_ORDER_UDLR, {0, 12}},
+    {2, 5, LP_ORDER_UDLR, {0, 12}},
+    {3, 0, LP_ORDER_UDLR, {18, 2, 10}},               /* trigonal planar */
+    {3, 1, LP_ORDER_UDLR, {2, 6, 10}},                /* trigonal pyramidal */
+    {3, 2, LP_ORDER_LUDR, {18, 6, 0}},                /* T-shaped */
+    {3, 3, LP_ORDER_LUDR, {18, 6, 0}},
+    {3, 4, LP_ORDER_LUDR, {18, 6, 0}},
+    {4, 0, LP_ORDER_UDLR, {0, 6, 12, 18}},            /* tetrahedral */
+    {4, 1, LP_ORDER_LUDR, {18, 6, 2, 22}},            /* seesaw */
+    {4, 2, LP_ORDER_LRUD, {3, 9, 15, 21}},            /* square planar */
+    {4, 3, LP_ORDER_LUDR, {18, 6, 2, 22}},            /* seesaw */
+    {5, 0, LP_ORDER_UDLR, {18, 6, 0, 9, 15}},         /* trigonal bipyramidal */
+    {5, 1, LP_ORDER_DULR, {18, 0, 12, 4, 8}},         /* square pyramidal */
+    {5, 2, LP_ORDER_UDLR, {18, 23, 4, 8, 13}},        /* pentagonal planar */
+    {6, 0, LP_ORDER_UDLR, {18, 6, 0, 12, 3, 15}},     /* octahedral */
+    {6, 1, LP_ORDER_UDLR, {18, 0, 12, 3, 9, 6}},      /* pentagonal pyramidal */
+    {7, 0, LP_ORDER_UDLR, {18, 6, 0, 3, 9, 12, 21}},  /* pentagonal bipyramidal */
+};
+
+bool layout_vsepr(const Molecule *mol, const LewisStructure *ls, AtomLayout *out)
+{
+    if (mol->num_atoms < 3) return false;
+
+    uint8_t neighbors[MAX_ATOMS];
+    uint8_t n = 0;
+    for (uint8_t b = 0; b < ls->num_bonds; b++) {
+        uint8_t a = ls->bonds[b].a;
+        uint8_t c = ls->bonds[b].b;
+        if (a == mol->central) neighbors[n++] = c;
+        else if (c == mol->central) neighbors[n++] = a;
+        else return false;
+    }
+    if (n + 1 != mol->num_atoms) return false;
+
+    uint8_t lp = ls->lone_pairs[mol->central];
+    const VseprProjection *row = NULL;
+    for (uint8_t r = 0; r < (uint8_t)(sizeof(vsepr_projections) / sizeof(vsepr_projections[0])); r++) {
+        if (vsepr_projections[r].bond_pairs == n && vsepr_projections[r].lone_pairs == lp) {
+            row = &vsepr_projections[r];
+            break;
         }
     }
+    if (row == NULL) return false;
 
+    out->x[mol->central] = LEWIS_CENTER_X;
+    out->y[mol->central] = LEWIS_CENTER_Y;
+    for (uint8_t k = 0; k < n; k++) {
+        uint8_t d = row->dirs[k];
+        out->x[neighbors[k]] = (int16_t)(LEWIS_CENTER_X + bond_dx[d]);
+        out->y[neighbors[k]] = (int16_t)(LEWIS_CENTER_Y + bond_dy[d]);
+    }
+    out->lp_slots[mol->central] = row->lp_order;
     return true;
 }
+
+/*
+ * Stress majorization: every atom pair is pulled toward a target distance
+ * derived from its bond-path length, with weight 1 / hops^2, one Gauss-Seidel sweep per iteration.
+ * Coordinates are Q4 fixed point. Weights are normalized once per graph,
+ * so a sweep costs one isqrt and one reciprocal lookup per pair.
+ */
+#define STRESS_Q        4
+#define STRESS_MIN_DIST (4 << STRESS_Q)
+#define STRESS_STILL    (1 << (STRESS_Q - 1))
+#define HOP_NONE        0xFF
+
+/*
+ * Target distance for a pair hops apart: BOND_LEN for a bond, 7/8 of the
+ * straight-path length beyond that (about a 120 degree bend per atom), so
+ * the longer targets do not stretch the bonds.
+ */
+#define STRESS_TARGET(hops) (((hops) == 1) ? (BOND_LEN << STRESS_Q) : (((hops) * (BOND_LEN << STRESS_Q) * 7) >> 3))
+
+/* round(256 / hops^2); longer paths get no weight. */
+static const uint16_t stress_weight_q8[12] = { 0, 256, 64, 28, 16, 10, 7, 5, 4, 3, 3, 2 };
+
+/* Bond-path lengths between all atoms into hop, n * n row-major. */
+static void graph_hops(const Molecule *mol, const LewisStructure *ls, uint8_t *hop)
+{
+    uint8_t n = mol->num_atoms;
+    memset(hop, HOP_NONE, (size_t)n * n);
+
+    for (uint8_t s = 0; s < n; s++) {
+        uint8_t *row = hop + (size_t)s * n;
+        uint8_t q[MAX_ATOMS];
+        uint8_t qh = 0;
+        uint8_t qt = 0;
+
+        row[s] = 0;
+        q[qt++] = s;
+        while (qh < qt) {
+            uint8_t u = q[qh++];
+            for (uint8_t b = 0; b < ls->num_bonds; b++) {
+                uint8_t v;
+                if (ls->bonds[b].a == u) v = ls->bonds[b].b;
+                else if (ls->bonds[b].b == u) v = ls->bonds[b].a;
+                else continue;
+                if (v >= n || row[v] != HOP_NONE) continue;
+                row[v] = (uint8_t)(row[u] + 1);
+                q[qt++] = v;
+            }
+        }
+    }
+}
+
+static uint16_t stress_weight(uint8_t hops)
+{
+    return (hops < sizeof(stress_weight_q8) / sizeof(stress_weight_q8[0])) ? stress_weight_q8[hops] : 0;
+}
+
+uint8_t layout_stress(const Molecule *mol, const LewisStructure *ls, AtomLayout *io, uint8_t max_sweeps, Arena *scratch)
+{
+    uint8_t n = mol->num_atoms;
+    if (n < 3) return 0;
+
+    /* Tables sized to this molecule, released together on return. */
+    size_t mark = arena_mark(scratch);
+    uint8_t *hop = (uint8_t *)arena_alloc(scratch, (size_t)n * n);
+    int16_t *wn = (int16_t *)arena_alloc(scratch, (size_t)n * n * sizeof(int16_t));
+    int32_t *x = (int32_t *)arena_alloc(scratch, n * sizeof(int32_t));
+    int32_t *y = (int32_t *)arena_alloc(scratch, n * sizeof(int32_t));
+    if (hop == NULL || wn == NULL || x == NULL || y == NULL) {
+        arena_release(scratch, mark);
+        return 0;
+    }
+    graph_hops(mol, ls, hop);
+
+    /* Per-atom weights in Q8 summing to exactly 256. */
+    for (uint8_t i = 0; i < n; i++) {
+        const uint8_t *hop_i = hop + (size_t)i * n;
+        int16_t *wn_i = wn + (size_t)i * n;
+        unsigned int total = 0;
+        for (uint8_t j = 0; j < n; j++) {
+            if (j != i) total += stress_weight(hop_i[j]);
+        }
+
+        int rest = (total > 0) ? 256 : 0;
+        int8_t heaviest = -1;
+        for (uint8_t j = 0; j < n; j++) {
+            wn_i[j] = 0;
+            if (j == i || total == 0) continue;
+            wn_i[j] = (int16_t)fx_udiv(stress_weight(hop_i[j]) * 256u + (total >> 1), total);
+            rest -= wn_i[j];
+            if (heaviest < 0 || wn_i[j] > wn_i[heaviest]) heaviest = (int8_t)j;
+        }
+        if (heaviest >= 0) wn_i[heaviest] = (int16_t)(wn_i[heaviest] + rest);
+    }
+
+    for (uint8_t i = 0; i < n; i++) {
+        x[i] = (int32_t)io->x[i] << STRESS_Q;
+        y[i] = (int32_t)io->y[i] << STRESS_Q;
+    }
+
+    uint8_t sweeps = 0;
+    while (sweeps < max_sweeps) {
+        int32_t moved = 0;
+        sweeps++;
+
+        for (uint8_t i = 0; i < n; i++) {
+            const uint8_t *hop_i = hop + (size_t)i * n;
+            const int16_t *wn_i = wn + (size_t)i * n;
+            int32_t ax = 0;
+            int32_t ay = 0;
+            bool any = false;
+
+            for (uint8_t j = 0; j < n; j++) {
+                if (wn_i[j] == 0) continue;
+                any = true;
+
+                int32_t dx = x[i] - x[j];
+                int32_t dy = y[i] - y[j];
+                if (dx == 0 && dy == 0) dx = (i < j) ? -1 : 1;
+
+                unsigned int dist = fx_isqrt32((uint32_t)(dx * dx + dy * dy));
+                if (dist < STRESS_MIN_DIST) dist = STRESS_MIN_DIST;
+
+                /* Target over current distance in Q8; |dx| <= dist keeps dx * s small. */
+                int s = fx_muldiv(STRESS_TARGET(hop_i[j]), 256, dist);
+                ax += wn_i[j] * (x[j] + ((dx * s) >> 8));
+                ay += wn_i[j] * (y[j] + ((dy * s) >> 8));
+            }
+            if (!any) continue;
+
+            int32_t nx = (ax + 128) >> 8;
+            int32_t ny = (ay + 128) >> 8;
+            int32_t mx = (nx > x[i]) ? nx - x[i] : x[i] - nx;
+            int32_t my = (ny > y[i]) ? ny - y[i] : y[i] - ny;
+            if (mx > moved) moved = mx;
+            if (my > moved) moved = my;
+            x[i] = nx;
+            y[i] = ny;
+        }
+
+        if (moved < STRESS_STILL) break;
+    }
+
+    /* Stress is translation-free; centre the bounding box on the drawing area. */
+    int32_t min_x = x[0], max_x = x[0], min_y = y[0], max_y = y[0];
+    for (uint8_t i = 1; i < n; i++) {
+        if (x[i] < min_x) min_x = x[i];
+        if (x[i] > max_x) max_x = x[i];
+        if (y[i] < min_y) min_y = y[i];
+        if (y[i] > max_y) max_y = y[i];
+    }
+    int32_t shift_x = ((int32_t)LEWIS_CENTER_X << STRESS_Q) - ((min_x + max_x) >> 1);
+    int32_t shift_y = ((int32_t)LEWIS_CENTER_Y << STRESS_Q) - ((min_y + max_y) >> 1);
+
+    for (uint8_t i = 0; i < n; i++) {
+        io->x[i] = (int16_t)((x[i] + shift_x + (1 << (STRESS_Q - 1))) >> STRESS_Q);
+        io->y[i] = (int16_t)((y[i] + shift_y + (1 << (STRESS_Q - 1))) >> STRESS_Q);
+    }
+    arena_release(scratch, mark);
+    return sweeps;
+}
+
+#if MAX_ATOMS > 16
+#error "ring detection keeps atom sets in uint16_t masks"
+#endif
+
+#define RING_MIN 3
+#define RING_MAX 8
+
+/*
+ * Vertices of regular 3..8-gons with BOND_LEN edges. Odd polygons point
+ * up; squares and hexagons sit flat so they fit the landscape screen. Each entry is the vertex's Q8 unit direction
+ * scaled at compile time by the circumradius, r_q8 = 256 / (2 sin(pi / n)),
+ * so placing a ring is table reads only.
+ */
+#define FX_RING(v, r_q8) ((int8_t)(((v) * (r_q8) * BOND_LEN + ((v) < 0 ? -32768 : 32768)) / 65536))
+
+/* Offset of each polygon's first vertex in ring_vx/ring_vy. */
+static const uint8_t ring_first[RING_MAX + 1] = { 0, 0, 0, 0, 3, 7, 12, 18, 25 };
+
+static const int8_t ring_vx[] = {
+    FX_RING(0, 148), FX_RING(222, 148), FX_RING(-222, 148),
+    FX_RING(-181, 181), FX_RING(181, 181), FX_RING(181, 181), FX_RING(-181, 181),
+    FX_RING(0, 218), FX_RING(243, 218), FX_RING(150, 218), FX_RING(-150, 218), FX_RING(-243, 218),
+    FX_RING(256, 256), FX_RING(128, 256), FX_RING(-128, 256), FX_RING(-256, 256), FX_RING(-128, 256), FX_RING(128, 256),
+    FX_RING(0, 295), FX_RING(200, 295), FX_RING(250, 295), FX_RING(111, 295), FX_RING(-111, 295), FX_RING(-250, 295), FX_RING(-200, 295),
+    FX_RING(0, 334), FX_RING(181, 334), FX_RING(256, 334), FX_RING(181, 334), FX_RING(0, 334), FX_RING(-181, 334), FX_RING(-256, 334), FX_RING(-181, 334)
+};
+
+static const int8_t ring_vy[] = {
+    FX_RING(-256, 148), FX_RING(128, 148), FX_RING(128, 148),
+    FX_RING(-181, 181), FX_RING(-181, 181), FX_RING(181, 181), FX_RING(181, 181),
+    FX_RING(-256, 218), FX_RING(-79, 218), FX_RING(207, 218), FX_RING(207, 218), FX_RING(-79, 218),
+    FX_RING(0, 256), FX_RING(222, 256), FX_RING(222, 256), FX_RING(0, 256), FX_RING(-222, 256), FX_RING(-222, 256),
+    FX_RING(-256, 295), FX_RING(-160, 295), FX_RING(57, 295), FX_RING(231, 295), FX_RING(231, 295), FX_RING(57, 295), FX_RING(-160, 295),
+    FX_RING(-256, 334), FX_RING(-181, 334), FX_RING(0, 334), FX_RING(181, 334), FX_RING(256, 334), FX_RING(181, 334), FX_RING(0, 334), FX_RING(-181, 334)
+};
+
+/* Outward bond over circumradius, 2 sin(pi / n), in Q8. */
+static const int16_t ring_out_q8[RING_MAX + 1] = { 0, 0, 0, 443, 362, 301, 256, 222, 196 };
+
+/* Every atom off the ring can hang from one vertex, so fans go up to FAN_MAX substituents. */
+#define FAN_MAX (MAX_ATOMS - RING_MIN)
+
+#if FAN_MAX > 9
+#error "fan tables cover at most 9 substituents per ring vertex"
+#endif
+
+/* Row n of the fan tables starts at fan_first[n]. */
+static const uint8_t fan_first[FAN_MAX + 1] = { 0, 0, 1, 3, 6, 10, 15, 21, 28, 36 };
+
+/* Q8 cos/sin of the turns fanning n substituents around a ring vertex's outward direction:
+ * 0, +-45 and 0/+-60 degrees for up to three, evenly over +-80 degrees beyond that. */
+static const int16_t fan_cos[] = {
+    256,
+    181, 181,
+    128, 256, 128,
+    44, 229, 229, 44,
+    44, 196, 256, 196, 44,
+    44, 171, 246, 246, 171, 44,
+    44, 153, 229, 256, 229, 153, 44,
+    44, 139, 212, 251, 251, 212, 139, 44,
+    44, 128, 196, 241, 256, 241, 196, 128, 44
+};
+static const int16_t fan_sin[] = {
+    0,
+    -181, 181,
+    -222, 0, 222,
+    -252, -115, 115, 252,
+    -252, -165, 0, 165, 252,
+    -252, -190, -71, 71, 190, 252,
+    -252, -205, -115, 0, 115, 205, 252,
+    -252, -215, -144, -51, 51, 144, 215, 252,
+    -252, -222, -165, -88, 0, 88, 165, 222, 252
+};
+
+static void bond_masks(const Molecule *mol, const LewisStructure *ls, uint16_t adj[MAX_ATOMS])
+{
+    memset(adj, 0, sizeof(uint16_t) * MAX_ATOMS);
+    for (uint8_t b = 0; b < ls->num_bonds; b++) {
+        uint8_t a = ls->bonds[b].a;
+        uint8_t c = ls->bonds[b].b;
+        if (a >= mol->num_atoms || c >= mol->num_atoms || a == c) continue;
+        adj[a] |= (uint16_t)(1u << c);
+        adj[c] |= (uint16_t)(1u << a);
+    }
+}
+
+static uint8_t lowest_atom(uint16_t mask)
+{
+    uint8_t i = 0;
+    while (!(mask & 1u)) {
+        mask >>= 1;
+        i++;
+    }
+    return i;
+}
+
+uint8_t layout_find_rings(const Molecule *mol, const LewisStructure *ls, LayoutRing *rings, uint8_t max_rings)
+{
+    uint16_t adj[MAX_ATOMS];
+    int8_t parent[MAX_ATOMS];
+    uint8_t stack[MAX_ATOMS];
+    uint16_t visited = 0;
+    uint8_t found = 0;
+
+    bond_masks(mol, ls, adj);
+
+    for (uint8_t root = 0; root < mol->num_atoms; root++) {
+        if (visited & (1u << root)) continue;
+
+        uint8_t sp = 0;
+        visited |= (uint16_t)(1u << root);
+        parent[root] = -1;
+        stack[sp++] = root;
+
+        while (sp > 0) {
+            uint8_t u = stack[sp - 1];
+            uint16_t next = (uint16_t)(adj[u] & ~visited);
+            if (next == 0) {
+                sp--;
+                continue;
+            }
+
+            uint8_t v = lowest_atom(next);
+            visited |= (uint16_t)(1u << v);
+            parent[v] = (int8_t)u;
+            stack[sp++] = v;
+
+            /* Visited neighbours other than the parent are ancestors: one ring each. */
+            uint16_t back = (uint16_t)(adj[v] & visited & ~(1u << u) & ~(1u << v));
+            while (back != 0 && found < max_rings) {
+                uint8_t w = lowest_atom(back);
+                back &= (uint16_t)~(1u << w);
+
+                LayoutRing *r = &rings[found++];
+                r->mask = 0;
+                r->len = 0;
+                for (int8_t a = (int8_t)v; a >= 0; a = parent[a]) {
+                    r->atoms[r->len++] = (uint8_t)a;
+                    r->mask |= (uint16_t)(1u << a);
+                    if (a == w) break;
+                }
+            }
+        }
+    }
+
+    return found;
+}
+
+/* Shift the bounding box of all atoms onto the drawing-area centre. */
+static void center_layout(const Molecule *mol, AtomLayout *out)
+{
+    int min_x = out->x[0], max_x = out->x[0], min_y = out->y[0], max_y = out->y[0];
+    for (uint8_t i = 1; i < mol->num_atoms; i++) {
+        if (out->x[i] < min_x) min_x = out->x[i];
+        if (out->x[i] > max_x) max_x = out->x[i];
+        if (out->y[i] < min_y) min_y = out->y[i];
+        if (out->y[i] > max_y) max_y = out->y[i];
+    }
+
+    int dx = LEWIS_CENTER_X - ((min_x + max_x) >> 1);
+    int dy = LEWIS_CENTER_Y - ((min_y + max_y) >> 1);
+    for (uint8_t i = 0; i < mol->num_atoms; i++) {
+        out->x[i] = (int16_t)(out->x[i] + dx);
+        out->y[i] = (int16_t)(out->y[i] + dy);
+    }
+}
+
+bool layout_rings(const Molecule *mol, const LewisStructure *ls, AtomLayout *out, Arena *scratch)
+{
+    LayoutRing rings[LAYOUT_MAX_RINGS];
+    uint8_t n_rings = layout_find_rings(mol, ls, rings, LAYOUT_MAX_RINGS);
+
+    const LayoutRing *ring = NULL;
+    for (uint8_t r = 0; r < n_rings; r++) {
+        if (rings[r].len < RING_MIN || rings[r].len > RING_MAX) continue;
+        if (ring == NULL || rings[r].len < ring->len) ring = &rings[r];
+    }
+    if (ring == NULL) return false;
+
+    uint16_t adj[MAX_ATOMS];
+    int8_t parent[MAX_ATOMS];
+    uint8_t q[MAX_ATOMS];
+    uint8_t qh = 0;
+    uint8_t qt = 0;
+    uint16_t placed = ring->mask;
+    bool needs_relax = n_rings > 1;
+
+    bond_masks(mol, ls, adj);
+
+    uint8_t base = ring_first[ring->len];
+    for (uint8_t k = 0; k < ring->len; k++) {
+        uint8_t atom = ring->atoms[k];
+        out->x[atom] = (int16_t)(LEWIS_CENTER_X + ring_vx[base + k]);
+        out->y[atom] = (int16_t)(LEWIS_CENTER_Y + ring_vy[base + k]);
+    }
+
+    /* Substituents fan out around each vertex's outward direction. */
+    for (uint8_t k = 0; k < ring->len; k++) {
+        uint8_t atom = ring->atoms[k];
+        uint16_t subs = (uint16_t)(adj[atom] & ~placed);
+        uint8_t n_subs = 0;
+        for (uint16_t m = subs; m != 0; m &= (uint16_t)(m - 1)) n_subs++;
+        if (n_subs == 0) continue;
+
+        int32_t vx = ring_vx[base + k];
+        int32_t vy = ring_vy[base + k];
+        int32_t scale = ring_out_q8[ring->len];
+        uint8_t fan = fan_first[n_subs];
+
+        for (; subs != 0; fan++) {
+            uint8_t sub = lowest_atom(subs);
+            subs &= (uint16_t)~(1u << sub);
+
+            int32_t c = fan_cos[fan];
+            int32_t sn = fan_sin[fan];
+            int32_t ox = ((vx * c - vy * sn) * scale + 32768) >> 16;
+            int32_t oy = ((vx * sn + vy * c) * scale + 32768) >> 16;
+            out->x[sub] = (int16_t)(out->x[atom] + ox);
+            out->y[sub] = (int16_t)(out->y[atom] + oy);
+
+            placed |= (uint16_t)(1u << sub);
+            parent[sub] = (int8_t)atom;
+            q[qt++] = sub;
+        }
+    }
+
+    /* Anything further out extends away from its parent, as in the tree layout. */
+    while (qh < qt) {
+        uint8_t p = q[qh++];
+        uint16_t kids = (uint16_t)(adj[p] & ~placed);
+        uint8_t n_kids = 0;
+        for (uint16_t m = kids; m != 0; m &= (uint16_t)(m - 1)) n_kids++;
+        if (n_kids == 0) continue;
+        needs_relax = true;
+
+        int dx = out->x[p] - out->x[(uint8_t)parent[p]];
+        int dy = out->y[p] - out->y[(uint8_t)parent[p]];
+        int len = abs(dx) > abs(dy) ? abs(dx) : abs(dy);
+        if (len == 0) len = 1;
+        int bx = out->x[p] + fx_muldiv(dx, BOND_LEN, (unsigned int)len);
+        int by = out->y[p] + fx_muldiv(dy, BOND_LEN, (unsigned int)len);
+        int px;
+        int py;
+        layout_bond_offset(dx, dy, 16, &px, &py);
+
+        for (uint8_t i = 0; kids != 0; i++) {
+            uint8_t kid = lowest_atom(kids);
+            kids &= (uint16_t)~(1u << kid);
+
+            int spread = i * 2 - (n_kids - 1);
+            out->x[kid] = (int16_t)(bx + px * spread);
+            out->y[kid] = (int16_t)(by + py * spread);
+            placed |= (uint16_t)(1u << kid);
+            parent[kid] = (int8_t)p;
+            q[qt++] = kid;
+        }
+    }
+
+    /* Other rings' atoms were reached through the ring's neighbours; anything else is disconnected. */
+    for (uint8_t i = 0; i < mol->num_atoms; i++) {
+        if (!(placed & (1u << i))) return false;
+    }
+
+    if (!needs_relax || layout_stress(mol, ls, out, LAYOUT_STRESS_SWEEPS, scratch) == 0) center_layout(mol, out);
+    return true;
+}
+
+/* True when some bond misses the central atom, i.e. the tree has an outer shell. */
+static bool has_outer_shell(const Molecule *mol, const LewisStructure *ls)
+{
+    for (uint8_t b = 0; b < ls->num_bonds; b++) {
+        if (ls->bonds[b].a != mol->central && ls->bonds[b].b != mol->central) return true;
+    }
+    return false;
+}
+
+static uint8_t slot_toward(int dx, int dy)
+{
+    if (abs(dy) >= abs(dx)) return (dy < 0) ? LP_SLOT_UP : LP_SLOT_DOWN;
+    return (dx < 0) ? LP_SLOT_LEFT : LP_SLOT_RIGHT;
+}
+
+/*
+ * Rank the four dot slots around each atom (0 above, 1 below, 2 left,
+ * 3 right): slots not facing a bond first, then the rest, in slot order.
+ * Renderer and overlap scorer both read this, so they always agree.
+ * Atoms already ranked by the placement (non-zero lp_slots) are kept.
+ */
+void layout_rank_lone_pairs(const Molecule *mol, const LewisStructure *ls, AtomLayout *out)
+{
+    uint8_t used[MAX_ATOMS];
+    memset(used, 0, sizeof(used));
+
+    for (uint8_t b = 0; b < ls->num_bonds; b++) {
+        uint8_t a = ls->bonds[b].a;
+        uint8_t c = ls->bonds[b].b;
+        int bdx = out->x[c] - out->x[a];
+        int bdy = out->y[c] - out->y[a];
+        used[a] |= (uint8_t)(1u << slot_toward(bdx, bdy));
+        used[c] |= (uint8_t)(1u << slot_toward(-bdx, -bdy));
+    }
+
+    for (uint8_t i = 0; i < mol->num_atoms; i++) {
+        if (out->lp_slots[i] != 0) continue;
+
+        uint8_t order = 0;
+        uint8_t n = 0;
+        for (uint8_t pass = 0; pass < 2; pass++) {
+            for (uint8_t slot = 0; slot < 4; slot++) {
+                bool is_used = (used[i] & (1u << slot)) != 0;
+                if (is_used != (pass == 1)) continue;
+                order |= (uint8_t)(slot << (n * 2));
+                n++;
+            }
+        }
+        out->lp_slots[i] = order;
+    }
+}
+
+void layout_lone_pair_dots(const AtomLayout *lay, uint8_t atom, uint8_t lp, int dots[4])
+{
+    uint8_t slot = layout_lone_pair_slot(lay, atom, lp);
+    int x = lay->x[atom];
+    int y = lay->y[atom];
+
+    switch (slot) {
+        case LP_SLOT_UP:    y -= DOT_DIST; break;
+        case LP_SLOT_DOWN:  y += DOT_DIST; break;
+        case LP_SLOT_LEFT:  x -= DOT_DIST; break;
+        default:            x += DOT_DIST; break;
+    }
+
+    if (slot < LP_SLOT_LEFT) {
+        dots[0] = x - 3;
+        dots[1] = y;
+        dots[2] = x + 3;
+        dots[3] = y;
+    } else {
+        dots[0] = x;
+        dots[1] = y - 3;
+        dots[2] = x;
+        dots[3] = y + 3;
+    }
+}
+
+static void place_atoms(const Molecule *mol, const LewisStructure *ls, AtomLayout *out, Arena *scratch)
+{
+    memset(out, 0, sizeof(*out));
+
+    if (mol->num_atoms == 0) {
+        return;
+    }
+    if (mol->num_atoms == 1) {
+        out->x[0] = LEWIS_CENTER_X;
+        out->y[0] = LEWIS_CENTER_Y;
+        return;
+    }
+    if (mol->num_atoms == 2) {
+        out->x[0] = LEWIS_CENTER_X - (BOND_LEN >> 1);
+        out->y[0] = LEWIS_CENTER_Y;
+        out->x[1] = LEWIS_CENTER_X + (BOND_LEN >> 1);
+        out->y[1] = LEWIS_CENTER_Y;
+        return;
+    }
+
+    /* Star-shaped molecules take their VSEPR class's projected angles. */
+    if (!has_outer_shell(mol, ls) && layout_vsepr(mol, ls, out)) return;
+    if (layout_rings(mol, ls, out, scratch)) return;
+
+    bool has_multiple = false;
+    for (uint8_t b = 0; b < ls->num_bonds; b++) {
+        if (ls->bonds[b].order > 1) {
+            has_multiple = true;
+            break;
+        }
+    }
+
+    if (has_multiple && layout_linear_chain(mol, ls, out)) return;
+    if (layout_tree_from_central(mol, ls, out)) {
+        /* Outer shells only get fixed slots plus a nudge; relax them from there. */
+        if (has_outer_shell(mol, ls)) layout_stress(mol, ls, out, LAYOUT_STRESS_SWEEPS, scratch);
+        return;
+    }
+    layout_radial(mol, out);
+}
+
+void layout_structure(const Molecule *mol, const LewisStructure *ls, AtomLayout *out, Arena *scratch)
+{
+    place_atoms(mol, ls, out, scratch);
+    layout_rank_lone_pairs(mol, ls, out);
+}
+
+void layout_molecule(Molecule *mol, Arena *scratch)
+{
+    size_t mark = arena_mark(scratch);
+    LewisStructure *ls = (LewisStructure *)arena_alloc(scratch, sizeof(LewisStructure));
+    for (uint8_t r = 0; r < mol->num_res; r++) {
+        molecule_form(mol, r, ls);
+        layout_structure(mol, ls, &mol->layout[r], scratch);
+    }
+    arena_release(scratch, mark);
+}
+
+void layout_bond_offset(int dx, int dy, int dist, int *ox, int *oy)
+{
+    int px = -dy;
+    int py = dx;
+    int len = (abs(px) > abs(py)) ? abs(px) : abs(py);
+    if (len == 0) len = 1;
+    *ox = fx_muldiv(px, dist, (unsigned int)len);
+    *oy = fx_muldiv(py, dist, (unsigned int)len);
+}
@@ -2,10 +2,84 @@
 #define LAYOUT_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "lewis_model.h"
 
-bool layout_linear_chain(const Molecule *mol, const LewisStructure *ls, int ax[MAX_ATOMS], int ay[MAX_ATOMS]);
-bool layout_tree_from_central(const Molecule *mol, const LewisStructure *ls, int ax[MAX_ATOMS], int ay[MAX_ATOMS]);
+bool layout_linear_chain(const Molecule *mol, const LewisStructure *ls, AtomLayout *out);
+bool layout_tree_from_central(const Molecule *mol, const LewisStructure *ls, AtomLayout *out);
+void layout_radial(const Molecule *mol, AtomLayout *out);
+
+/*
+ * Place a central atom's neighbours at the projected angles of its VSEPR
+ * class and rank its lone-pair slots into the directions left free.
+ * Returns false unless every bond touches the central atom and the class
+ * has a projection.
+ */
+bool layout_vsepr(const Molecule *mol, const LewisStructure *ls, AtomLayout *out);
+
+/* One cycle of the bond graph: atoms in ring order and as a bit set. */
+#define LAYOUT_MAX_RINGS 4
+
+typedef struct {
+    uint16_t mask;
+    uint8_t len;
+    uint8_t atoms[MAX_ATOMS];
+} LayoutRing;
+
+/*
+ * Fundamental cycle basis from a bitmask DFS: one ring per back edge,
+ * at most max_rings. Returns the number of rings found.
+ */
+uint8_t layout_find_rings(const Molecule *mol, const LewisStructure *ls, LayoutRing *rings, uint8_t max_rings);
+
+/*
+ * Put the smallest 3..8-membered ring on a regular polygon with its
+ * substituents pointing outward; further atoms extend from their parents
+ * and are relaxed with layout_stress. Returns false without such a ring.
+ */
+bool layout_rings(const Molecule *mol, const LewisStructure *ls, AtomLayout *out, Arena *scratch);
+
+/*
+ * Refine io in place by fixed-point stress majorization toward graph
+ * distances in BOND_LEN units, then centre it. Stops after max_sweeps or
+ * once no atom moves by half a pixel. Returns the sweeps run; 0 leaves io
+ * untouched (fewer than 3 atoms, or scratch too small for the n * n
+ * tables).
+ */
+#define LAYOUT_STRESS_SWEEPS 40
+uint8_t layout_stress(const Molecule *mol, const LewisStructure *ls, AtomLayout *io, uint8_t max_sweeps, Arena *scratch);
+
+/* Lone-pair dot slots around an atom, ranked per atom in AtomLayout.lp_slots. */
+#define LP_SLOT_UP    0
+#define LP_SLOT_DOWN  1
+#define LP_SLOT_LEFT  2
+#define LP_SLOT_RIGHT 3
+#define LP_MAX_SLOTS  4
+
+#define layout_lone_pair_slot(lay, atom, lp) ((uint8_t)(((lay)->lp_slots[(atom)] >> ((lp) * 2)) & 3u))
+
+/* Rank lone-pair slots for atoms the placement left unranked (lp_slots 0). */
+void layout_rank_lone_pairs(const Molecule *mol, const LewisStructure *ls, AtomLayout *out);
+
+/* Centers of the two dots of lone pair lp (< LP_MAX_SLOTS): { x1, y1, x2, y2 }. */
+void layout_lone_pair_dots(const AtomLayout *lay, uint8_t atom, uint8_t lp, int dots[4]);
+
+/*
+ * Pick the best layout helper for one resonance form and rank lone-pair
+ * slots. Buffers come from scratch, which needs LEWIS_SCRATCH_USE free,
+ * and are released before returning.
+ */
+void layout_structure(const Molecule *mol, const LewisStructure *ls, AtomLayout *out, Arena *scratch);
+
+/* Fill mol->layout[] for every generated resonance form; scratch as above. */
+void layout_molecule(Molecule *mol, Arena *scratch);
+
+/*
+ * Perpendicular offset of length dist (Chebyshev) for the parallel strokes
+ * of a multiple bond running along (dx, dy). Two reciprocal-table divides
+ * (fx_muldiv), no runtime divide.
+ */
+void layout_bond_offset(int dx, int dy, int dist, int *ox, int *oy);
 
 #endif
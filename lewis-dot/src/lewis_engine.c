@@ -2,6 +2,8 @@
 
 #include <string.h>
 
+#include "layout.h"
+
 typedef struct {
     uint8_t valence_pairs;
     uint8_t bond_pairs;
@@ -59,7 +61,7 @@ static int electrons_on_atom(const LewisStructure *ls, uint8_t atom_idx)
     return (ls->lone_pairs[atom_idx] * 2) + (bond_order_sum(ls, atom_idx) * 2);
 }
 
-static void recompute_formal_charges(const Molecule *mol, LewisStructure *ls)
+void lewis_recompute_formal_charges(const Molecule *mol, LewisStructure *ls)
 {
     for (uint8_t i = 0; i < mol->num_atoms; i++) {
         int val = elements[mol->atoms[i].elem].valence;
@@ -78,26 +80,13 @@ static int formal_charge_sum(const Molecule *mol, const LewisStructure *ls)
     return sum;
 }
 
-static bool structures_equal(const Molecule *mol, const LewisStructure *a, const LewisStructure *b)
-{
-    if (a->num_bonds != b->num_bonds) {
-        return false;
-    }
-    for (uint8_t i = 0; i < a->num_bonds; i++) {
-        if (a->bonds[i].a != b->bonds[i].a) return false;
-        if (a->bonds[i].b != b->bonds[i].b) return false;
-        if (a->bonds[i].order != b->bonds[i].order) return false;
-    }
-    for (uint8_t i = 0; i < mol->num_atoms; i++) {
-        if (a->lone_pairs[i] != b->lone_pairs[i]) return false;
-    }
-    return true;
-}
-
-static bool resonance_exists(const Molecule *mol, const LewisStructure *candidate)
+/* Deltas are canonical (fixed change order), so equal forms have equal deltas; form 0 has none. */
+static bool resonance_exists(const Molecule *mol, const ResonanceDelta *candidate)
 {
-    for (uint8_t i = 0; i < mol->num_res; i++) {
-        if (structures_equal(mol, candidate, &mol->res[i])) {
+    if (candidate->count == 0) return true;
+    for (uint8_t i = 1; i < mol->num_res; i++) {
+        const ResonanceDelta *d = &mol->delta[i - 1];
+        if (d->count == candidate->count && memcmp(d->change, candidate->change, d->count) == 0) {
             return true;
         }
     }
@@ -507,13 +496,8 @@ static uint8_t find_central(const Molecule *mol)
     return 0;
 }
 
-/*
- * Generate one Lewis structure.
- * Returns false when electron count/connectivity/octet constraints are invalid.
- */
-static bool generate_structure(const Molecule *mol, LewisStructure *ls, InvalidReason *reason)
+static bool electron_count_valid(const Molecule *mol, InvalidReason *reason)
 {
-    memset(ls, 0, sizeof(*ls));
     *reason = INVALID_NONE;
 
     if (mol->num_atoms == 0) {
@@ -528,14 +512,15 @@ static bool generate_structure(const Molecule *mol, LewisStructure *ls, InvalidR
         *reason = INVALID_ODD_ELECTRONS;
         return false;
     }
+    return true;
+}
 
-    int ve_pool = mol->total_ve;
-
-    if (!build_skeleton(mol, ls, &ve_pool)) {
-        *reason = INVALID_SKELETON;
-        return false;
-    }
-
+/*
+ * Distribute the ve_pool electrons left after the skeleton's bonds as lone
+ * pairs, then promote central bonds until the shells are satisfied.
+ */
+static bool place_electrons(const Molecule *mol, LewisStructure *ls, int ve_pool, InvalidReason *reason)
+{
     /* Fill terminal atoms first */
     for (uint8_t i = 0; i < mol->num_atoms; i++) {
         if (i == mol->central) continue;
@@ -597,7 +582,7 @@ static bool generate_structure(const Molecule *mol, LewisStructure *ls, InvalidR
 
     /* For period 3+ centers, use available lone pairs to reduce charge separation. */
     if (elements[mol->atoms[mol->central].elem].period >= 3) {
-        recompute_formal_charges(mol, ls);
+        lewis_recompute_formal_charges(mol, ls);
         for (int pass = 0; pass < MAX_BONDS; pass++) {
             if (ls->formal_charge[mol->central] <= 0) break;
 
@@ -623,11 +608,11 @@ static bool generate_structure(const Molecule *mol, LewisStructure *ls, InvalidR
             uint8_t term = (ls->bonds[best_bond].a == mol->central) ? ls->bonds[best_bond].b : ls->bonds[best_bond].a;
             ls->bonds[best_bond].order++;
             ls->lone_pairs[term]--;
-            recompute_formal_charges(mol, ls);
+            lewis_recompute_formal_charges(mol, ls);
         }
     }
 
-    recompute_formal_charges(mol, ls);
+    lewis_recompute_formal_charges(mol, ls);
 
     for (uint8_t i = 0; i < mol->num_atoms; i++) {
         int electrons = electrons_on_atom(ls, i);
@@ -645,15 +630,147 @@ static bool generate_structure(const Molecule *mol, LewisStructure *ls, InvalidR
     return true;
 }
 
-void generate_resonance(Molecule *mol)
+/*
+ * Generate one Lewis structure.
+ * Returns false when electron count/connectivity/octet constraints are invalid.
+ */
+static bool generate_structure(const Molecule *mol, LewisStructure *ls, InvalidReason *reason)
+{
+    memset(ls, 0, sizeof(*ls));
+    if (!electron_count_valid(mol, reason)) return false;
+
+    int ve_pool = mol->total_ve;
+
+    if (!build_skeleton(mol, ls, &ve_pool)) {
+        *reason = INVALID_SKELETON;
+        return false;
+    }
+    return place_electrons(mol, ls, ve_pool, reason);
+}
+
+/* In-range, loop-free bonds of order 1-3 that connect every atom. */
+static bool skeleton_connected(const Molecule *mol, const LewisStructure *skeleton)
+{
+    if (skeleton->num_bonds > MAX_BONDS) return false;
+
+    uint16_t reached = 1;
+    for (uint8_t b = 0; b < skeleton->num_bonds; b++) {
+        const Bond *bond = &skeleton->bonds[b];
+        if (bond->a >= mol->num_atoms || bond->b >= mol->num_atoms || bond->a == bond->b) return false;
+        if (bond->order < 1 || bond->order > 3) return false;
+    }
+
+    /* Grow the reached set until it stops changing; at most num_atoms passes. */
+    for (uint8_t pass = 0; pass < mol->num_atoms; pass++) {
+        uint16_t before = reached;
+        for (uint8_t b = 0; b < skeleton->num_bonds; b++) {
+            uint16_t ends = (uint16_t)((1u << skeleton->bonds[b].a) | (1u << skeleton->bonds[b].b));
+            if (reached & ends) reached |= ends;
+        }
+        if (reached == before) break;
+    }
+    return reached == (uint16_t)((1u << mol->num_atoms) - 1u);
+}
+
+/* As generate_structure, keeping the caller's bonds and their orders. */
+static bool generate_structure_on_skeleton(const Molecule *mol, const LewisStructure *skeleton,
+                                           LewisStructure *ls, InvalidReason *reason)
+{
+    memset(ls, 0, sizeof(*ls));
+    if (!electron_count_valid(mol, reason)) return false;
+    if (!skeleton_connected(mol, skeleton)) {
+        *reason = INVALID_SKELETON;
+        return false;
+    }
+
+    int ve_pool = mol->total_ve;
+    ls->num_bonds = skeleton->num_bonds;
+    for (uint8_t b = 0; b < skeleton->num_bonds; b++) {
+        ls->bonds[b] = skeleton->bonds[b];
+        ve_pool -= 2 * skeleton->bonds[b].order;
+    }
+    if (ve_pool < 0) {
+        *reason = INVALID_SKELETON;
+        return false;
+    }
+    return place_electrons(mol, ls, ve_pool, reason);
+}
+
+/*
+ * Center of a given skeleton: the non-hydrogen atom with the most
+ * non-hydrogen neighbours, then the most neighbours, then the lowest
+ * electronegativity.
+ */
+static uint8_t skeleton_central(const Molecule *mol, const LewisStructure *skeleton)
+{
+    uint8_t heavy_deg[MAX_ATOMS] = { 0 };
+    uint8_t deg[MAX_ATOMS] = { 0 };
+    for (uint8_t b = 0; b < skeleton->num_bonds; b++) {
+        uint8_t a = skeleton->bonds[b].a;
+        uint8_t c = skeleton->bonds[b].b;
+        deg[a]++;
+        deg[c]++;
+        if (mol->atoms[c].elem != ELEM_H) heavy_deg[a]++;
+        if (mol->atoms[a].elem != ELEM_H) heavy_deg[c]++;
+    }
+
+    int best = -1;
+    for (uint8_t i = 0; i < mol->num_atoms; i++) {
+        if (mol->atoms[i].elem == ELEM_H) continue;
+        if (best < 0 || heavy_deg[i] > heavy_deg[best]) {
+            best = i;
+            continue;
+        }
+        if (heavy_deg[i] < heavy_deg[best]) continue;
+        if (deg[i] > deg[best] ||
+            (deg[i] == deg[best] && elements[mol->atoms[i].elem].eneg < elements[mol->atoms[best].elem].eneg)) {
+            best = i;
+        }
+    }
+    return (best >= 0) ? (uint8_t)best : 0;
+}
+
+/*
+ * Resumable solver. Each call to lewis_solve_step() performs up to
+ * work_budget units, where one unit is one candidate center, one
+ * resonance seed bond, or one form layout. All progress lives in the
+ * LewisSolver context, so a caller can interleave solving with frames.
+ */
+enum {
+    SOLVE_STAGE_CENTERS = 0,
+    SOLVE_STAGE_RESONANCE,
+    SOLVE_STAGE_LAYOUT,
+    SOLVE_STAGE_DONE
+};
+
+/*
+ * Every step's scratch fits LEWIS_SCRATCH_USE and is released before the
+ * step returns, so checking the free space once here covers the whole solve.
+ * Without it the solver starts out done and mol is left alone.
+ */
+static bool scratch_fits(LewisSolver *s, Molecule *mol, Arena *scratch)
+{
+    memset(s, 0, sizeof(*s));
+    s->mol = mol;
+    s->scratch = scratch;
+    if (scratch->cap - scratch->used >= LEWIS_SCRATCH_USE) return true;
+    s->stage = SOLVE_STAGE_DONE;
+    return false;
+}
+
+/* Shared begin: reset results and count electrons. False when there are no atoms. */
+static bool solve_reset(LewisSolver *s, Molecule *mol)
 {
+    s->stage = SOLVE_STAGE_CENTERS;
+
     mol->num_res = 0;
     mol->cur_res = 0;
     mol->invalid_reason = INVALID_NONE;
 
     if (mol->num_atoms == 0) {
         mol->invalid_reason = INVALID_NO_ATOMS;
-        return;
+        s->stage = SOLVE_STAGE_DONE;
+        return false;
     }
 
     mol->total_ve = 0;
@@ -661,151 +778,289 @@ void generate_resonance(Molecule *mol)
         mol->total_ve += elements[mol->atoms[i].elem].valence;
     }
     mol->total_ve -= mol->charge;
+    return true;
+}
+
+bool lewis_solve_begin(LewisSolver *s, Molecule *mol, Arena *scratch)
+{
+    if (!scratch_fits(s, mol, scratch)) return false;
+    if (!solve_reset(s, mol)) return true;
 
-    uint8_t candidates[MAX_ATOMS];
-    uint8_t elem_counts[NUM_ELEMENTS];
-    uint8_t n_candidates = gather_center_candidates(mol, candidates);
-    memset(elem_counts, 0, sizeof(elem_counts));
+    s->n_candidates = gather_center_candidates(mol, s->candidates);
     for (uint8_t i = 0; i < mol->num_atoms; i++) {
-        elem_counts[mol->atoms[i].elem]++;
-    }
-
-    bool found_valid = false;
-    uint8_t best_center = find_central(mol);
-    LewisStructure best_ls;
-    InvalidReason first_reason = INVALID_NONE;
-
-    int best_sum_abs_fc = 0;
-    int best_nonzero_fc = 0;
-    int best_abs_central_fc = 0;
-    uint8_t best_count = 0;
-    bool best_terminal = false;
-    uint8_t best_eneg = 0;
-    uint8_t best_period = 0;
-    uint8_t best_atomic_num = 0;
-
-    for (uint8_t ci = 0; ci < n_candidates; ci++) {
-        mol->central = candidates[ci];
-
-        LewisStructure cand_ls;
-        InvalidReason reason = INVALID_NONE;
-        if (!generate_structure(mol, &cand_ls, &reason)) {
-            if (first_reason == INVALID_NONE) {
-                first_reason = reason;
-            }
-            continue;
-        }
+        s->elem_counts[mol->atoms[i].elem]++;
+    }
+    s->best_center = find_central(mol);
+    return true;
+}
+
+bool lewis_solve_begin_skeleton(LewisSolver *s, Molecule *mol, const LewisStructure *skeleton, Arena *scratch)
+{
+    if (!scratch_fits(s, mol, scratch)) return false;
+    if (!solve_reset(s, mol)) return true;
+
+    size_t mark = arena_mark(scratch);
+    LewisStructure *first = (LewisStructure *)arena_alloc(scratch, sizeof(LewisStructure));
+    InvalidReason reason = INVALID_NONE;
+    mol->central = skeleton_central(mol, skeleton);
+    bool ok = generate_structure_on_skeleton(mol, skeleton, first, &reason);
+    if (ok) packed_store(&mol->base, first, mol->num_atoms);
+    arena_release(scratch, mark);
+    if (!ok) {
+        mol->invalid_reason = reason;
+        s->stage = SOLVE_STAGE_DONE;
+        return true;
+    }
+
+    /* No center search: go straight to resonance and layout. */
+    mol->num_res = 1;
+    s->stage = SOLVE_STAGE_RESONANCE;
+    return true;
+}
 
-        int cand_sum_abs_fc = 0;
-        int cand_nonzero_fc = 0;
-        int cand_abs_central_fc = 0;
-        score_structure(mol, &cand_ls, &cand_sum_abs_fc, &cand_nonzero_fc, &cand_abs_central_fc);
-
-        const Element *cand_elem = &elements[mol->atoms[mol->central].elem];
-        uint8_t cand_count = elem_counts[mol->atoms[mol->central].elem];
-        bool cand_terminal = center_is_terminal_elem(mol->atoms[mol->central].elem);
-
-        if (!found_valid ||
-            candidate_is_better(cand_sum_abs_fc,
-                                cand_nonzero_fc,
-                                cand_abs_central_fc,
-                                cand_count,
-                                cand_terminal,
-                                cand_elem->eneg,
-                                cand_elem->period,
-                                cand_elem->atomic_num,
-                                best_sum_abs_fc,
-                                best_nonzero_fc,
-                                best_abs_central_fc,
-                                best_count,
-                                best_terminal,
-                                best_eneg,
-                                best_period,
-                                best_atomic_num)) {
-            found_valid = true;
-            best_center = mol->central;
-            memcpy(&best_ls, &cand_ls, sizeof(best_ls));
-
-            best_sum_abs_fc = cand_sum_abs_fc;
-            best_nonzero_fc = cand_nonzero_fc;
-            best_abs_central_fc = cand_abs_central_fc;
-            best_count = cand_count;
-            best_terminal = cand_terminal;
-            best_eneg = cand_elem->eneg;
-            best_period = cand_elem->period;
-            best_atomic_num = cand_elem->atomic_num;
+/* Try one candidate center and keep it when it beats the best so far. */
+static void solve_center_step(LewisSolver *s)
+{
+    Molecule *mol = s->mol;
+    mol->central = s->candidates[s->next_candidate++];
+
+    size_t mark = arena_mark(s->scratch);
+    LewisStructure *cand_ls = (LewisStructure *)arena_alloc(s->scratch, sizeof(LewisStructure));
+    InvalidReason reason = INVALID_NONE;
+    if (!generate_structure(mol, cand_ls, &reason)) {
+        if (s->first_reason == INVALID_NONE) {
+            s->first_reason = reason;
         }
+        arena_release(s->scratch, mark);
+        return;
+    }
+
+    LewisCenterScore cand;
+    score_structure(mol, cand_ls, &cand.sum_abs_fc, &cand.nonzero_fc, &cand.abs_central_fc);
+
+    const Element *cand_elem = &elements[mol->atoms[mol->central].elem];
+    cand.count = s->elem_counts[mol->atoms[mol->central].elem];
+    cand.terminal = center_is_terminal_elem(mol->atoms[mol->central].elem);
+    cand.eneg = cand_elem->eneg;
+    cand.period = cand_elem->period;
+    cand.atomic_num = cand_elem->atomic_num;
+
+    const LewisCenterScore *best = &s->best;
+    if (!s->found_valid ||
+        candidate_is_better(cand.sum_abs_fc,
+                            cand.nonzero_fc,
+                            cand.abs_central_fc,
+                            cand.count,
+                            cand.terminal,
+                            cand.eneg,
+                            cand.period,
+                            cand.atomic_num,
+                            best->sum_abs_fc,
+                            best->nonzero_fc,
+                            best->abs_central_fc,
+                            best->count,
+                            best->terminal,
+                            best->eneg,
+                            best->period,
+                            best->atomic_num)) {
+        s->found_valid = true;
+        s->best_center = mol->central;
+        memcpy(&s->best_ls, cand_ls, sizeof(s->best_ls));
+        s->best = cand;
     }
+    arena_release(s->scratch, mark);
+}
 
-    if (!found_valid) {
-        mol->invalid_reason = (first_reason == INVALID_NONE) ? INVALID_SKELETON : first_reason;
+/* Commit the winning center, or record why no candidate worked. */
+static void solve_finish_centers(LewisSolver *s)
+{
+    Molecule *mol = s->mol;
+
+    if (!s->found_valid) {
+        mol->invalid_reason = (s->first_reason == INVALID_NONE) ? INVALID_SKELETON : s->first_reason;
+        s->stage = SOLVE_STAGE_DONE;
         return;
     }
 
-    mol->central = best_center;
-    memcpy(&mol->res[0], &best_ls, sizeof(best_ls));
+    mol->central = s->best_center;
+    packed_store(&mol->base, &s->best_ls, mol->num_atoms);
     mol->invalid_reason = INVALID_NONE;
     mol->num_res = 1;
 
-    for (uint8_t seed_idx = 0; seed_idx < mol->num_res && mol->num_res < MAX_RESONANCE; seed_idx++) {
-        LewisStructure seed;
-        memcpy(&seed, &mol->res[seed_idx], sizeof(seed));
+    s->seed_idx = 0;
+    s->src = 0;
+    s->stage = SOLVE_STAGE_RESONANCE;
+}
 
-        for (uint8_t src = 0; src < seed.num_bonds && mol->num_res < MAX_RESONANCE; src++) {
-            if (!(seed.bonds[src].a == mol->central || seed.bonds[src].b == mol->central)) {
-                continue;
-            }
-            if (seed.bonds[src].order <= 1) {
-                continue;
-            }
+/* Every new form made by moving the multiple bond src of seed, built in cand. */
+static void shift_resonance_bond(LewisSolver *s, const LewisStructure *seed, uint8_t src, LewisStructure *cand)
+{
+    Molecule *mol = s->mol;
+    if (!(seed->bonds[src].a == mol->central || seed->bonds[src].b == mol->central)) {
+        return;
+    }
+    if (seed->bonds[src].order <= 1) {
+        return;
+    }
 
-            uint8_t src_term = (seed.bonds[src].a == mol->central) ? seed.bonds[src].b : seed.bonds[src].a;
-            uint8_t src_elem = mol->atoms[src_term].elem;
-            if (is_protonated_terminal_oxygen(mol, &seed, src_term)) continue;
-            uint8_t shift = seed.bonds[src].order - 1;
+    uint8_t src_term = (seed->bonds[src].a == mol->central) ? seed->bonds[src].b : seed->bonds[src].a;
+    uint8_t src_elem = mol->atoms[src_term].elem;
+    if (is_protonated_terminal_oxygen(mol, seed, src_term)) return;
+    uint8_t shift = seed->bonds[src].order - 1;
 
-            for (uint8_t dst = 0; dst < seed.num_bonds && mol->num_res < MAX_RESONANCE; dst++) {
-                if (dst == src) continue;
-                if (!(seed.bonds[dst].a == mol->central || seed.bonds[dst].b == mol->central)) {
-                    continue;
-                }
+    for (uint8_t dst = 0; dst < seed->num_bonds && mol->num_res < MAX_RESONANCE; dst++) {
+        if (dst == src) continue;
+        if (!(seed->bonds[dst].a == mol->central || seed->bonds[dst].b == mol->central)) {
+            continue;
+        }
 
-                uint8_t dst_term = (seed.bonds[dst].a == mol->central) ? seed.bonds[dst].b : seed.bonds[dst].a;
-                if (mol->atoms[dst_term].elem != src_elem) continue;
-                if (mol->atoms[dst_term].elem == ELEM_H) continue;
-                if (is_protonated_terminal_oxygen(mol, &seed, dst_term)) continue;
-                if (seed.bonds[dst].order >= seed.bonds[src].order) continue;
-                if ((uint8_t)(seed.bonds[dst].order + shift) > 3) continue;
-                if (seed.lone_pairs[dst_term] < shift) continue;
+        uint8_t dst_term = (seed->bonds[dst].a == mol->central) ? seed->bonds[dst].b : seed->bonds[dst].a;
+        if (mol->atoms[dst_term].elem != src_elem) continue;
+        if (mol->atoms[dst_term].elem == ELEM_H) continue;
+        if (is_protonated_terminal_oxygen(mol, seed, dst_term)) continue;
+        if (seed->bonds[dst].order >= seed->bonds[src].order) continue;
+        if ((uint8_t)(seed->bonds[dst].order + shift) > 3) continue;
+        if (seed->lone_pairs[dst_term] < shift) continue;
 
-                LewisStructure cand;
-                memcpy(&cand, &seed, sizeof(cand));
+        memcpy(cand, seed, sizeof(*cand));
 
-                cand.bonds[src].order = 1;
-                cand.lone_pairs[src_term] += shift;
+        cand->bonds[src].order = 1;
+        cand->lone_pairs[src_term] += shift;
 
-                cand.bonds[dst].order += shift;
-                cand.lone_pairs[dst_term] -= shift;
+        cand->bonds[dst].order += shift;
+        cand->lone_pairs[dst_term] -= shift;
 
-                recompute_formal_charges(mol, &cand);
-                if (formal_charge_sum(mol, &cand) != mol->charge) continue;
+        lewis_recompute_formal_charges(mol, cand);
+        if (formal_charge_sum(mol, cand) != mol->charge) continue;
 
-                bool valid = true;
-                for (uint8_t i = 0; i < mol->num_atoms; i++) {
-                    int electrons = electrons_on_atom(&cand, i);
-                    if (!shell_satisfied(mol, i, electrons, i == mol->central)) {
-                        valid = false;
-                        break;
-                    }
+        bool valid = true;
+        for (uint8_t i = 0; i < mol->num_atoms; i++) {
+            int electrons = electrons_on_atom(cand, i);
+            if (!shell_satisfied(mol, i, electrons, i == mol->central)) {
+                valid = false;
+                break;
+            }
+        }
+        if (!valid) continue;
+
+        ResonanceDelta delta;
+        if (!resonance_delta(mol, cand, &delta)) continue;
+        if (resonance_exists(mol, &delta)) continue;
+
+        mol->delta[mol->num_res - 1] = delta;
+        mol->num_res++;
+    }
+}
+
+/* Shift the multiple bond at (seed_idx, src) onto each equivalent central bond. */
+static void solve_resonance_step(LewisSolver *s)
+{
+    Molecule *mol = s->mol;
+    size_t mark = arena_mark(s->scratch);
+    LewisStructure *seed = (LewisStructure *)arena_alloc(s->scratch, sizeof(LewisStructure));
+    LewisStructure *cand = (LewisStructure *)arena_alloc(s->scratch, sizeof(LewisStructure));
+    molecule_form(mol, s->seed_idx, seed);
+    uint8_t src = s->src;
+
+    if (++s->src >= seed->num_bonds) {
+        s->src = 0;
+        s->seed_idx++;
+    }
+    if (src < seed->num_bonds) {
+        shift_resonance_bond(s, seed, src, cand);
+    }
+    arena_release(s->scratch, mark);
+}
+
+/* Lay out form layout_idx. */
+static void solve_layout_step(LewisSolver *s)
+{
+    Molecule *mol = s->mol;
+    size_t mark = arena_mark(s->scratch);
+    LewisStructure *ls = (LewisStructure *)arena_alloc(s->scratch, sizeof(LewisStructure));
+    molecule_form(mol, s->layout_idx, ls);
+    layout_structure(mol, ls, &mol->layout[s->layout_idx], s->scratch);
+    arena_release(s->scratch, mark);
+}
+
+LewisSolveStatus lewis_solve_step(LewisSolver *s, uint16_t work_budget)
+{
+    Molecule *mol = s->mol;
+
+    while (work_budget > 0 && s->stage != SOLVE_STAGE_DONE) {
+        switch (s->stage) {
+            case SOLVE_STAGE_CENTERS:
+                if (s->next_candidate < s->n_candidates) {
+                    solve_center_step(s);
+                    work_budget--;
+                    s->work_done++;
+                } else {
+                    solve_finish_centers(s);
                 }
-                if (!valid) continue;
-                if (resonance_exists(mol, &cand)) continue;
+                break;
 
-                memcpy(&mol->res[mol->num_res], &cand, sizeof(cand));
-                mol->num_res++;
-            }
+            case SOLVE_STAGE_RESONANCE:
+                if (s->seed_idx < mol->num_res && mol->num_res < MAX_RESONANCE) {
+                    solve_resonance_step(s);
+                    work_budget--;
+                    s->work_done++;
+                } else {
+                    s->layout_idx = 0;
+                    s->stage = SOLVE_STAGE_LAYOUT;
+                }
+                break;
+
+            case SOLVE_STAGE_LAYOUT:
+                /* Layout depends only on each form's bonds, so compute it once here. */
+                if (s->layout_idx < mol->num_res) {
+                    solve_layout_step(s);
+                    s->layout_idx++;
+                    work_budget--;
+                    s->work_done++;
+                } else {
+                    s->stage = SOLVE_STAGE_DONE;
+                }
+                break;
+
+            default:
+                s->stage = SOLVE_STAGE_DONE;
+                break;
         }
     }
+
+    return (s->stage == SOLVE_STAGE_DONE) ? LEWIS_SOLVE_DONE : LEWIS_SOLVE_IN_PROGRESS;
+}
+
+uint8_t lewis_solve_percent(const LewisSolver *s)
+{
+    if (s->stage == SOLVE_STAGE_DONE) return 100;
+
+    /* Centers weigh most; resonance and layout share the rest. */
+    if (s->stage == SOLVE_STAGE_CENTERS) {
+        if (s->n_candidates == 0) return 0;
+        return (uint8_t)((s->next_candidate * 70) / s->n_candidates);
+    }
+    if (s->stage == SOLVE_STAGE_RESONANCE) {
+        /* num_res grows while seeds are walked, so scale by the cap to stay monotonic. */
+        return (uint8_t)(70 + (s->seed_idx * 20) / MAX_RESONANCE);
+    }
+    return (uint8_t)(90 + (s->layout_idx * 10) / (s->mol->num_res ? s->mol->num_res : 1));
+}
+
+void generate_resonance(Molecule *mol)
+{
+    LewisSolver solver;
+    lewis_solve_begin(&solver, mol, lewis_scratch());
+    while (lewis_solve_step(&solver, UINT16_MAX) != LEWIS_SOLVE_DONE) {
+    }
+}
+
+void generate_resonance_with_skeleton(Molecule *mol, const LewisStructure *skeleton)
+{
+    LewisSolver solver;
+    lewis_solve_begin_skeleton(&solver, mol, skeleton, lewis_scratch());
+    while (lewis_solve_step(&solver, UINT16_MAX) != LEWIS_SOLVE_DONE) {
+    }
 }
 
 static void fill_vsepr_fallback(VseprInfo *out)
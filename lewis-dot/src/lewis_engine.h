@@ -13,7 +13,77 @@ typedef struct {
     const char *bond_angle;
 } VseprInfo;
 
+typedef enum {
+    LEWIS_SOLVE_IN_PROGRESS = 0,
+    LEWIS_SOLVE_DONE
+} LewisSolveStatus;
+
+typedef struct {
+    int      sum_abs_fc;
+    int      nonzero_fc;
+    int      abs_central_fc;
+    uint8_t  count;
+    bool     terminal;
+    uint8_t  eneg;
+    uint8_t  period;
+    uint8_t  atomic_num;
+} LewisCenterScore;
+
+/* Explicit state for a time-sliced solve; see lewis_solve_step(). */
+typedef struct {
+    Molecule *mol;
+    Arena    *scratch;     /* per-step buffers, released before each step returns */
+    uint8_t  stage;
+    uint16_t work_done;    /* work units spent so far */
+
+    /* Center search */
+    uint8_t  candidates[MAX_ATOMS];
+    uint8_t  n_candidates;
+    uint8_t  next_candidate;
+    uint8_t  elem_counts[NUM_ELEMENTS];
+    bool     found_valid;
+    uint8_t  best_center;
+    LewisStructure best_ls;
+    LewisCenterScore best;
+    InvalidReason first_reason;
+
+    /* Resonance enumeration and layout */
+    uint8_t  seed_idx;
+    uint8_t  src;
+    uint8_t  layout_idx;
+} LewisSolver;
+
+/* Run a whole solve on lewis_scratch(); equivalent to begin + step until done. */
 void generate_resonance(Molecule *mol);
+
+/*
+ * Solve on a known skeleton (bonds and starting orders, e.g. from
+ * smiles_parse) instead of searching centers and building one: only
+ * electron placement, resonance and layout run. The center is the atom
+ * with the most non-hydrogen neighbours.
+ */
+void generate_resonance_with_skeleton(Molecule *mol, const LewisStructure *skeleton);
+
+/*
+ * Resumable solve. lewis_solve_step() performs at most work_budget units
+ * (one candidate center, one resonance seed bond, or one form layout each)
+ * and returns LEWIS_SOLVE_DONE once mol holds the final result. Callers
+ * with a clock (the 32 kHz timer, a service deadline) step one unit at a
+ * time while time remains.
+ *
+ * Candidate structures, resonance candidates and layout tables come from
+ * scratch, so a solve never allocates from the heap; each step gives back
+ * what it took. Concurrent solvers need separate arenas. Begin returns
+ * false, with the solver already done and mol untouched, when scratch has
+ * less than LEWIS_SCRATCH_USE free (a LEWIS_SCRATCH_BYTES buffer always
+ * has it).
+ */
+bool lewis_solve_begin(LewisSolver *s, Molecule *mol, Arena *scratch);
+bool lewis_solve_begin_skeleton(LewisSolver *s, Molecule *mol, const LewisStructure *skeleton, Arena *scratch);
+LewisSolveStatus lewis_solve_step(LewisSolver *s, uint16_t work_budget);
+uint8_t lewis_solve_percent(const LewisSolver *s);
+/* Formal charge of every atom from its valence, lone pairs and bond orders. */
+void lewis_recompute_formal_charges(const Molecule *mol, LewisStructure *ls);
 bool lewis_get_vsepr_info(const Molecule *mol, const LewisStructure *ls, VseprInfo *out);
 const char *invalid_reason_message(InvalidReason reason);
 
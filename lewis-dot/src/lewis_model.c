@@ -55,8 +55,157 @@ void init_pt_grid(void)
     }
 }
 
+static uint8_t scratch_buf[LEWIS_SCRATCH_BYTES];
+static Arena scratch;
+
+Arena *lewis_scratch(void)
+{
+    if (scratch.base == NULL) arena_init(&scratch, scratch_buf, sizeof(scratch_buf));
+    return &scratch;
+}
+
 void molecule_reset(Molecule *mol)
 {
     memset(mol, 0, sizeof(*mol));
     mol->invalid_reason = INVALID_NONE;
 }
+
+void packed_store(PackedStructure *p, const LewisStructure *ls, uint8_t num_atoms)
+{
+    memset(p, 0, sizeof(*p));
+    p->num_bonds = ls->num_bonds;
+    for (uint8_t k = 0; k < ls->num_bonds; k++) {
+        p->ends[k] = (uint8_t)(ls->bonds[k].a | (ls->bonds[k].b << 4));
+        p->orders[k >> 2] |= (uint8_t)((ls->bonds[k].order & 3u) << ((k & 3u) * 2));
+    }
+    for (uint8_t i = 0; i < num_atoms; i++) {
+        uint8_t bit = (uint8_t)(i * 3);
+        uint16_t v = (uint16_t)((ls->lone_pairs[i] & 7u) << (bit & 7));
+        p->lone_pairs[bit >> 3] |= (uint8_t)v;
+        if (v > 0xFF) p->lone_pairs[(bit >> 3) + 1] |= (uint8_t)(v >> 8);
+    }
+}
+
+Bond packed_bond(const PackedStructure *p, uint8_t k)
+{
+    Bond b;
+    b.a = p->ends[k] & 0x0Fu;
+    b.b = p->ends[k] >> 4;
+    b.order = (p->orders[k >> 2] >> ((k & 3u) * 2)) & 3u;
+    return b;
+}
+
+uint8_t packed_lone_pairs(const PackedStructure *p, uint8_t atom)
+{
+    uint8_t bit = (uint8_t)(atom * 3);
+    uint8_t shift = bit & 7;
+    uint16_t v = p->lone_pairs[bit >> 3];
+    /* Fields starting at bit 6 or 7 run into the next byte. */
+    if (shift > 5) v |= (uint16_t)(p->lone_pairs[(bit >> 3) + 1] << 8);
+    return (uint8_t)((v >> shift) & 7u);
+}
+
+int8_t packed_formal_charge(const Molecule *mol, const PackedStructure *p, uint8_t atom)
+{
+    int fc = elements[mol->atoms[atom].elem].valence - 2 * packed_lone_pairs(p, atom);
+    for (uint8_t k = 0; k < p->num_bonds; k++) {
+        uint8_t ends = p->ends[k];
+        if ((ends & 0x0Fu) == atom || (ends >> 4) == atom) fc -= (p->orders[k >> 2] >> ((k & 3u) * 2)) & 3u;
+    }
+    return (int8_t)fc;
+}
+
+bool resonance_delta(const Molecule *mol, const LewisStructure *ls, ResonanceDelta *d)
+{
+    const PackedStructure *base = &mol->base;
+    d->count = 0;
+    if (ls->num_bonds != base->num_bonds) return false;
+
+    for (uint8_t k = 0; k < ls->num_bonds; k++) {
+        Bond b = packed_bond(base, k);
+        if (b.a != ls->bonds[k].a || b.b != ls->bonds[k].b) return false;
+        if (b.order == ls->bonds[k].order) continue;
+        d->change[d->count++] = (uint8_t)((k << 3) | ls->bonds[k].order);
+    }
+    for (uint8_t i = 0; i < mol->num_atoms; i++) {
+        if (packed_lone_pairs(base, i) == ls->lone_pairs[i]) continue;
+        if (ls->lone_pairs[i] > 7) return false;
+        d->change[d->count++] = (uint8_t)(RES_DELTA_LP | (i << 3) | ls->lone_pairs[i]);
+    }
+    return true;
+}
+
+/* Set one field and move the formal charges it feeds by the difference. */
+static void set_field(LewisStructure *ls, uint8_t change, uint8_t value)
+{
+    uint8_t idx = (change >> 3) & 0x0Fu;
+    if (change & RES_DELTA_LP) {
+        ls->formal_charge[idx] = (int8_t)(ls->formal_charge[idx] - 2 * (value - ls->lone_pairs[idx]));
+        ls->lone_pairs[idx] = value;
+    } else {
+        Bond *b = &ls->bonds[idx];
+        int diff = value - b->order;
+        ls->formal_charge[b->a] = (int8_t)(ls->formal_charge[b->a] - diff);
+        ls->formal_charge[b->b] = (int8_t)(ls->formal_charge[b->b] - diff);
+        b->order = value;
+    }
+}
+
+void resonance_apply(const Molecule *mol, uint8_t r, LewisStructure *ls)
+{
+    if (r == 0) return;
+    const ResonanceDelta *d = &mol->delta[r - 1];
+    for (uint8_t c = 0; c < d->count; c++) set_field(ls, d->change[c], d->change[c] & 7u);
+}
+
+void resonance_revert(const Molecule *mol, uint8_t r, LewisStructure *ls)
+{
+    if (r == 0) return;
+    const ResonanceDelta *d = &mol->delta[r - 1];
+    for (uint8_t c = 0; c < d->count; c++) {
+        uint8_t change = d->change[c];
+        uint8_t idx = (change >> 3) & 0x0Fu;
+        uint8_t value = (change & RES_DELTA_LP) ? packed_lone_pairs(&mol->base, idx) : packed_bond(&mol->base, idx).order;
+        set_field(ls, change, value);
+    }
+}
+
+void molecule_form(const Molecule *mol, uint8_t r, LewisStructure *ls)
+{
+    const PackedStructure *p = &mol->base;
+    memset(ls, 0, sizeof(*ls));
+    ls->num_bonds = p->num_bonds;
+    for (uint8_t k = 0; k < p->num_bonds; k++) ls->bonds[k] = packed_bond(p, k);
+
+    for (uint8_t i = 0; i < mol->num_atoms; i++) {
+        ls->lone_pairs[i] = packed_lone_pairs(p, i);
+        ls->formal_charge[i] = (int8_t)(elements[mol->atoms[i].elem].valence - 2 * ls->lone_pairs[i]);
+    }
+    for (uint8_t k = 0; k < ls->num_bonds; k++) {
+        ls->formal_charge[ls->bonds[k].a] = (int8_t)(ls->formal_charge[ls->bonds[k].a] - ls->bonds[k].order);
+        ls->formal_charge[ls->bonds[k].b] = (int8_t)(ls->formal_charge[ls->bonds[k].b] - ls->bonds[k].order);
+    }
+    resonance_apply(mol, r, ls);
+}
+
+uint8_t molecule_formula(const Molecule *mol, char buf[MOLECULE_FORMULA_MAX])
+{
+    bool done[MAX_ATOMS] = { false };
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < mol->num_atoms; i++) {
+        if (done[i]) continue;
+
+        uint8_t count = 0;
+        for (uint8_t j = i; j < mol->num_atoms; j++) {
+            if (mol->atoms[j].elem == mol->atoms[i].elem) {
+                done[j] = true;
+                count++;
+            }
+        }
+        for (const char *s = elements[mol->atoms[i].elem].symbol; *s != '\0'; s++) buf[n++] = *s;
+        if (count >= 10) buf[n++] = (char)('0' + count / 10u);
+        if (count > 1) buf[n++] = (char)('0' + count % 10u);
+    }
+    buf[n] = '\0';
+    return n;
+}
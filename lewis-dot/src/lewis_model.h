@@ -4,6 +4,8 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "arena.h"
+
 /* Screen layout constants */
 #define SCR_W           320
 #define SCR_H           240
@@ -105,6 +107,55 @@ typedef struct {
     int8_t   formal_charge[MAX_ATOMS];
 } LewisStructure;
 
+/*
+ * Stored resonance form 0: a LewisStructure without the derived formal
+ * charges, bit-packed so Molecule stays small (21 bytes against 61).
+ * The engine builds forms as LewisStructure and stores them with
+ * packed_store(); readers unpack a whole form with molecule_form() or
+ * read single fields of form 0 through the packed_* accessors.
+ *
+ *   ends        per bond: a in the low nibble, b in the high nibble
+ *   orders      per bond: order, 2 bits, bond k at bits 2k..2k+1
+ *   lone_pairs  per atom: count, 3 bits, atom i at bits 3i..3i+2
+ */
+#define PACKED_ORDER_BYTES ((MAX_BONDS * 2 + 7) / 8)
+#define PACKED_LP_BYTES    ((MAX_ATOMS * 3 + 7) / 8)
+
+#if MAX_ATOMS > 16
+#error "packed bond endpoints are one nibble each"
+#endif
+
+typedef struct {
+    uint8_t  ends[MAX_BONDS];
+    uint8_t  orders[PACKED_ORDER_BYTES];
+    uint8_t  lone_pairs[PACKED_LP_BYTES];
+    uint8_t  num_bonds;
+} PackedStructure;
+
+/*
+ * Resonance form r > 0 as changes against form 0, which has the same
+ * skeleton: one byte per change, bond orders first, then lone pairs, each
+ * in ascending index order, so equal forms have equal deltas. A change is
+ * index << 3 | new value, plus RES_DELTA_LP for a lone-pair count.
+ * There is room for one change per bond and per atom, so any form on the
+ * same skeleton fits whatever its heavy-atom count (SMILES and host
+ * compositions are not held to MAX_HEAVY).
+ */
+#define RES_DELTA_MAX (MAX_BONDS + MAX_ATOMS)
+#define RES_DELTA_LP  0x80u
+
+typedef struct {
+    uint8_t  count;
+    uint8_t  change[RES_DELTA_MAX];
+} ResonanceDelta;
+
+/* Screen-space atom positions for one resonance form (see layout.c). */
+typedef struct {
+    int16_t  x[MAX_ATOMS];
+    int16_t  y[MAX_ATOMS];
+    uint8_t  lp_slots[MAX_ATOMS]; /* lone-pair slot order, 2 bits per pair; 0 = unranked */
+} AtomLayout;
+
 typedef enum {
     INVALID_NONE = 0,
     INVALID_NO_ATOMS,
@@ -122,15 +173,72 @@ typedef struct {
     int8_t   charge;       /* overall molecular charge */
 
     /* Generated structures */
-    LewisStructure res[MAX_RESONANCE];
+    PackedStructure base;  /* resonance form 0 */
+    ResonanceDelta delta[MAX_RESONANCE - 1]; /* form r is base + delta[r - 1] */
+    AtomLayout layout[MAX_RESONANCE]; /* atom positions per resonance form */
     uint8_t  num_res;
     uint8_t  cur_res;      /* currently displayed resonance form */
 
     uint8_t  central;      /* index of central atom */
-    int      total_ve;     /* total valence electrons */
-    InvalidReason invalid_reason;
+    int8_t   total_ve;     /* total valence electrons, at most 8 * MAX_ATOMS + 2 */
+    uint8_t  invalid_reason; /* InvalidReason */
 } Molecule;
 
 void molecule_reset(Molecule *mol);
 
+/*
+ * Store ls (bonds and the first num_atoms lone-pair counts, each below 8)
+ * into p. Unused fields are zeroed, so equal forms pack to equal bytes.
+ */
+void packed_store(PackedStructure *p, const LewisStructure *ls, uint8_t num_atoms);
+
+Bond packed_bond(const PackedStructure *p, uint8_t k);
+uint8_t packed_lone_pairs(const PackedStructure *p, uint8_t atom);
+
+/* Valence minus lone-pair and bonding electrons, computed on demand. */
+int8_t packed_formal_charge(const Molecule *mol, const PackedStructure *p, uint8_t atom);
+
+/*
+ * Changes that turn form 0 into ls. False when the skeleton differs or a
+ * lone-pair count does not fit in a change byte.
+ */
+bool resonance_delta(const Molecule *mol, const LewisStructure *ls, ResonanceDelta *d);
+
+/*
+ * Switch an unpacked form in place in O(delta), formal charges included:
+ * apply turns form 0 into form r, revert turns form r back into form 0.
+ * Form 0 has an empty delta.
+ */
+void resonance_apply(const Molecule *mol, uint8_t r, LewisStructure *ls);
+void resonance_revert(const Molecule *mol, uint8_t r, LewisStructure *ls);
+
+/* Expand form r of mol into ls, formal charges included. */
+void molecule_form(const Molecule *mol, uint8_t r, LewisStructure *ls);
+
+/*
+ * Formula with elements in order of first appearance ("CO3"), like the
+ * selected-atoms bar; the charge is not included. Returns the length.
+ */
+#define MOLECULE_FORMULA_MAX (MAX_ATOMS * 2 + 1)
+uint8_t molecule_formula(const Molecule *mol, char buf[MOLECULE_FORMULA_MAX]);
+
+/*
+ * Arena space one solver or layout step needs at these limits. The layout
+ * step is the deepest: its unpacked form plus layout_stress's hop, weight
+ * and coordinate tables, n * n and n entries for n atoms.
+ * LEWIS_SCRATCH_BYTES is a buffer size that still leaves that much after
+ * arena_init() aligns it.
+ */
+#define LEWIS_SCRATCH_USE (ARENA_ROUND(sizeof(LewisStructure)) + \
+                           ARENA_ROUND(MAX_ATOMS * MAX_ATOMS * sizeof(uint8_t)) + \
+                           ARENA_ROUND(MAX_ATOMS * MAX_ATOMS * sizeof(int16_t)) + \
+                           2 * ARENA_ROUND(MAX_ATOMS * sizeof(int32_t)))
+#define LEWIS_SCRATCH_BYTES (LEWIS_SCRATCH_USE + ARENA_ALIGN - 1u)
+
+/*
+ * Shared LEWIS_SCRATCH_BYTES arena for single-threaded callers
+ * (generate_resonance, lewis_pack decoding, the app). Threads pass their own.
+ */
+Arena *lewis_scratch(void);
+
 #endif
@@ -0,0 +1,257 @@
+#include "lewis_pack.h"
+
+#include <string.h>
+
+#include "layout.h"
+
+#if MAX_ATOMS > 16 || MAX_BONDS > 15 || MAX_RESONANCE > 7 || NUM_ELEMENTS > 64
+#error "lewis_pack field widths no longer cover the model limits"
+#endif
+
+#define PACK_COUNT_BITS  4
+#define PACK_ELEM_BITS   6
+#define PACK_CHARGE_BITS 4
+#define PACK_ATOM_BITS   4
+#define PACK_RES_BITS    3
+#define PACK_REASON_BITS 3
+#define PACK_ORDER_BITS  2
+#define PACK_LP_BITS     3
+
+void lewis_bits_writer_init(LewisBitWriter *w, uint8_t *buf, size_t cap)
+{
+    w->buf = buf;
+    w->cap = cap;
+    w->bitpos = 0;
+    w->overflow = false;
+}
+
+void lewis_bits_put(LewisBitWriter *w, uint32_t value, uint8_t nbits)
+{
+    /* Most significant bit first, so records read naturally in a hex dump. */
+    while (nbits-- > 0) {
+        size_t byte = w->bitpos >> 3;
+        if (byte >= w->cap) {
+            w->overflow = true;
+            return;
+        }
+
+        uint8_t mask = (uint8_t)(0x80u >> (w->bitpos & 7));
+        if ((value >> nbits) & 1u) w->buf[byte] |= mask;
+        else w->buf[byte] &= (uint8_t)~mask;
+        w->bitpos++;
+    }
+}
+
+void lewis_bits_reader_init(LewisBitReader *r, const uint8_t *buf, size_t len)
+{
+    r->buf = buf;
+    r->len = len;
+    r->bitpos = 0;
+    r->overrun = false;
+}
+
+uint32_t lewis_bits_get(LewisBitReader *r, uint8_t nbits)
+{
+    uint32_t value = 0;
+    while (nbits-- > 0) {
+        size_t byte = r->bitpos >> 3;
+        if (byte >= r->len) {
+            r->overrun = true;
+            return 0;
+        }
+
+        value = (value << 1) | ((r->buf[byte] >> (7 - (r->bitpos & 7))) & 1u);
+        r->bitpos++;
+    }
+    return value;
+}
+
+static bool encodable(const Molecule *mol)
+{
+    if (mol->num_atoms == 0 || mol->num_atoms > MAX_ATOMS) return false;
+    if (mol->charge < -8 || mol->charge > 7) return false;
+    if (mol->central >= mol->num_atoms || mol->num_res > MAX_RESONANCE) return false;
+
+    /* Stored forms already hold lone pairs in PACK_LP_BITS; only orders need checking. */
+    if (mol->num_res == 0) return true;
+    if (mol->base.num_bonds > MAX_BONDS) return false;
+    for (uint8_t b = 0; b < mol->base.num_bonds; b++) {
+        if (packed_bond(&mol->base, b).order == 0) return false;
+    }
+    for (uint8_t r = 1; r < mol->num_res; r++) {
+        const ResonanceDelta *d = &mol->delta[r - 1];
+        for (uint8_t c = 0; c < d->count; c++) {
+            if (!(d->change[c] & RES_DELTA_LP) && (d->change[c] & 7u) == 0) return false;
+        }
+    }
+    return true;
+}
+
+static void put_skeleton(LewisBitWriter *w, const PackedStructure *p)
+{
+    lewis_bits_put(w, p->num_bonds, PACK_COUNT_BITS);
+    for (uint8_t b = 0; b < p->num_bonds; b++) {
+        Bond bond = packed_bond(p, b);
+        lewis_bits_put(w, bond.a, PACK_ATOM_BITS);
+        lewis_bits_put(w, bond.b, PACK_ATOM_BITS);
+    }
+}
+
+bool lewis_pack_write(LewisBitWriter *w, const Molecule *mol)
+{
+    if (!encodable(mol)) return false;
+
+    size_t start = w->bitpos;
+    bool was_overflow = w->overflow;
+    w->overflow = false;
+
+    lewis_bits_put(w, (uint32_t)(mol->num_atoms - 1), PACK_COUNT_BITS);
+    for (uint8_t i = 0; i < mol->num_atoms; i++) {
+        lewis_bits_put(w, mol->atoms[i].elem, PACK_ELEM_BITS);
+    }
+    lewis_bits_put(w, (uint32_t)mol->charge & 0xFu, PACK_CHARGE_BITS);
+    lewis_bits_put(w, mol->central, PACK_ATOM_BITS);
+    lewis_bits_put(w, mol->num_res, PACK_RES_BITS);
+
+    if (mol->num_res == 0) {
+        lewis_bits_put(w, (uint32_t)mol->invalid_reason, PACK_REASON_BITS);
+    } else {
+        /* Stored forms share form 0's skeleton, so it is always written once. */
+        lewis_bits_put(w, 1u, 1);
+        put_skeleton(w, &mol->base);
+
+        LewisStructure ls;
+        molecule_form(mol, 0, &ls);
+        for (uint8_t r = 0; r < mol->num_res; r++) {
+            resonance_apply(mol, r, &ls);
+            for (uint8_t b = 0; b < ls.num_bonds; b++) {
+                lewis_bits_put(w, ls.bonds[b].order, PACK_ORDER_BITS);
+            }
+            for (uint8_t i = 0; i < mol->num_atoms; i++) {
+                lewis_bits_put(w, ls.lone_pairs[i], PACK_LP_BITS);
+            }
+            resonance_revert(mol, r, &ls);
+        }
+    }
+
+    /* Pad to a byte so every record starts on a byte boundary. */
+    if (w->bitpos & 7) lewis_bits_put(w, 0, (uint8_t)(8 - (w->bitpos & 7)));
+
+    if (w->overflow) {
+        w->bitpos = start;
+        w->overflow = true;
+        return false;
+    }
+    w->overflow = was_overflow;
+    return true;
+}
+
+static bool get_skeleton(LewisBitReader *r, const Molecule *mol, LewisStructure *ls)
+{
+    ls->num_bonds = (uint8_t)lewis_bits_get(r, PACK_COUNT_BITS);
+    if (ls->num_bonds > MAX_BONDS) return false;
+
+    for (uint8_t b = 0; b < ls->num_bonds; b++) {
+        ls->bonds[b].a = (uint8_t)lewis_bits_get(r, PACK_ATOM_BITS);
+        ls->bonds[b].b = (uint8_t)lewis_bits_get(r, PACK_ATOM_BITS);
+        if (ls->bonds[b].a >= mol->num_atoms || ls->bonds[b].b >= mol->num_atoms) return false;
+        if (ls->bonds[b].a == ls->bonds[b].b) return false;
+    }
+    return true;
+}
+
+bool lewis_pack_read_forms(LewisBitReader *r, Molecule *mol)
+{
+    molecule_reset(mol);
+
+    mol->num_atoms = (uint8_t)(lewis_bits_get(r, PACK_COUNT_BITS) + 1);
+    if (mol->num_atoms > MAX_ATOMS) return false;
+    for (uint8_t i = 0; i < mol->num_atoms; i++) {
+        mol->atoms[i].elem = (uint8_t)lewis_bits_get(r, PACK_ELEM_BITS);
+        if (mol->atoms[i].elem >= NUM_ELEMENTS) return false;
+    }
+
+    uint32_t charge = lewis_bits_get(r, PACK_CHARGE_BITS);
+    mol->charge = (int8_t)((charge & 0x8u) ? (int)charge - 16 : (int)charge);
+    mol->central = (uint8_t)lewis_bits_get(r, PACK_ATOM_BITS);
+    mol->num_res = (uint8_t)lewis_bits_get(r, PACK_RES_BITS);
+    if (mol->central >= mol->num_atoms || mol->num_res > MAX_RESONANCE) return false;
+
+    mol->total_ve = 0;
+    for (uint8_t i = 0; i < mol->num_atoms; i++) {
+        mol->total_ve += elements[mol->atoms[i].elem].valence;
+    }
+    mol->total_ve -= mol->charge;
+
+    if (mol->num_res == 0) {
+        mol->invalid_reason = (InvalidReason)lewis_bits_get(r, PACK_REASON_BITS);
+    } else {
+        /*
+         * Decode each form into a working structure; form 0 is stored
+         * packed, later forms as deltas, which rejects forms on another
+         * skeleton.
+         */
+        LewisStructure ls;
+        memset(&ls, 0, sizeof(ls));
+        bool shared = lewis_bits_get(r, 1) != 0;
+        if (shared && !get_skeleton(r, mol, &ls)) return false;
+
+        for (uint8_t f = 0; f < mol->num_res; f++) {
+            if (!shared && !get_skeleton(r, mol, &ls)) return false;
+
+            for (uint8_t b = 0; b < ls.num_bonds; b++) {
+                ls.bonds[b].order = (uint8_t)lewis_bits_get(r, PACK_ORDER_BITS);
+                if (ls.bonds[b].order == 0) return false;
+            }
+            for (uint8_t i = 0; i < mol->num_atoms; i++) {
+                ls.lone_pairs[i] = (uint8_t)lewis_bits_get(r, PACK_LP_BITS);
+            }
+            if (f == 0) packed_store(&mol->base, &ls, mol->num_atoms);
+            else if (!resonance_delta(mol, &ls, &mol->delta[f - 1])) return false;
+        }
+    }
+
+    if (r->bitpos & 7) r->bitpos += 8 - (r->bitpos & 7);
+    return !r->overrun && r->bitpos <= r->len * 8;
+}
+
+bool lewis_pack_read(LewisBitReader *r, Molecule *mol)
+{
+    if (!lewis_pack_read_forms(r, mol)) return false;
+
+    layout_molecule(mol, lewis_scratch());
+    return true;
+}
+
+void lewis_pack_key(const Molecule *mol, uint8_t key[LEWIS_PACK_KEY_BYTES])
+{
+    uint8_t n = mol->num_atoms > MAX_ATOMS ? MAX_ATOMS : mol->num_atoms;
+    memset(key, 0, LEWIS_PACK_KEY_BYTES);
+    key[0] = n;
+
+    /* Insertion sort: at most MAX_ATOMS entries. */
+    for (uint8_t i = 0; i < n; i++) {
+        uint8_t elem = mol->atoms[i].elem;
+        uint8_t j = i;
+        while (j > 0 && key[j] > elem) {
+            key[j + 1] = key[j];
+            j--;
+        }
+        key[j + 1] = elem;
+    }
+    key[n + 1] = (uint8_t)mol->charge;
+}
+
+size_t lewis_pack(const Molecule *mol, uint8_t *buf, size_t cap)
+{
+    LewisBitWriter w;
+    lewis_bits_writer_init(&w, buf, cap);
+    return lewis_pack_write(&w, mol) ? (w.bitpos >> 3) : 0;
+}
+
+size_t lewis_unpack(Molecule *mol, const uint8_t *buf, size_t len)
+{
+    LewisBitReader r;
+    lewis_bits_reader_init(&r, buf, len);
+    return lewis_pack_read(&r, mol) ? (r.bitpos >> 3) : 0;
+}
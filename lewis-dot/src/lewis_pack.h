@@ -0,0 +1,71 @@
+#ifndef LEWIS_PACK_H
+#define LEWIS_PACK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "lewis_model.h"
+
+/*
+ * Compact, allocation-free binary form of a solved Molecule.
+ *
+ * A record is a bit stream, most significant bit first, padded to a whole
+ * byte:
+ *   4  atom count - 1        6  element index, per atom
+ *   4  charge (signed)       4  central atom index
+ *   3  resonance forms       (0 forms: 3 bits InvalidReason, end)
+ *   1  shared skeleton       every form has the same bond endpoints
+ *   skeleton, once if shared, else per form:
+ *     4  bond count          4 + 4  endpoints, per bond
+ *   per form: 2 bond order per bond, then 3 lone pairs per atom
+ * Formal charges, total_ve and layouts are recomputed on decode.
+ * A typical solved result packs into 8-20 bytes.
+ */
+#define LEWIS_PACK_MAX_BYTES \
+    ((4 + MAX_ATOMS * 6 + 12 + MAX_RESONANCE * (4 + MAX_BONDS * 10 + MAX_ATOMS * 3) + 7) / 8)
+
+typedef struct {
+    uint8_t *buf;
+    size_t cap;     /* bytes */
+    size_t bitpos;
+    bool overflow;  /* a write ran past cap */
+} LewisBitWriter;
+
+typedef struct {
+    const uint8_t *buf;
+    size_t len;     /* bytes */
+    size_t bitpos;
+    bool overrun;   /* a read ran past len */
+} LewisBitReader;
+
+void lewis_bits_writer_init(LewisBitWriter *w, uint8_t *buf, size_t cap);
+void lewis_bits_put(LewisBitWriter *w, uint32_t value, uint8_t nbits);
+void lewis_bits_reader_init(LewisBitReader *r, const uint8_t *buf, size_t len);
+uint32_t lewis_bits_get(LewisBitReader *r, uint8_t nbits);
+
+/*
+ * Append one record to a stream. Returns false, leaving w unchanged, when
+ * the molecule does not fit the encoding or the buffer.
+ */
+bool lewis_pack_write(LewisBitWriter *w, const Molecule *mol);
+
+/* Read the next record into mol (layouts included). False on bad data. */
+bool lewis_pack_read(LewisBitReader *r, Molecule *mol);
+
+/* As lewis_pack_read, but leaves mol->layout zeroed for callers that store layouts. */
+bool lewis_pack_read_forms(LewisBitReader *r, Molecule *mol);
+
+/*
+ * Canonical lookup key for a composition: atom count, element indices in
+ * ascending order, then the charge, zero-padded. Inputs that differ only
+ * in atom order share a key.
+ */
+#define LEWIS_PACK_KEY_BYTES (MAX_ATOMS + 2)
+void lewis_pack_key(const Molecule *mol, uint8_t key[LEWIS_PACK_KEY_BYTES]);
+
+/* Single-record helpers: bytes written or consumed, 0 on failure. */
+size_t lewis_pack(const Molecule *mol, uint8_t *buf, size_t cap);
+size_t lewis_unpack(Molecule *mol, const uint8_t *buf, size_t len);
+
+#endif
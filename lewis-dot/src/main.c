@@ -22,12 +22,13 @@
 #include <keypadc.h>
 #include <sys/timers.h>
 #include <stdbool.h>
-#include <stdlib.h>
 #include <string.h>
 
-#include "layout.h"
+#include "cache_appvar.h"
+#include "display_list.h"
 #include "lewis_engine.h"
 #include "lewis_model.h"
+#include "result_cache.h"
 #include "ui_periodic.h"
 #include "ui_theme.h"
 #include "ui_text.h"
@@ -37,6 +38,140 @@ static Molecule mol;
 static uint8_t cur_row = 0;
 static uint8_t cur_col = 0;
 
+/*
+ * The Lewis screen only changes on resonance, charge and card-toggle
+ * events, so it is rendered once into each graphx buffer and then left
+ * alone. This counts the buffers that still hold a stale frame.
+ */
+static uint8_t lewis_stale_buffers = 0;
+
+/* Primitives of the shown form; rebuilt on the first draw after a change. */
+static DisplayList lewis_dl;
+static bool lewis_dl_dirty = true;
+
+/* The shown form, unpacked once per solve and then switched by delta. */
+static LewisStructure shown_form;
+
+static void invalidate_lewis(void)
+{
+    lewis_stale_buffers = 2;
+    lewis_dl_dirty = true;
+}
+
+/*
+ * Recently solved compositions, loaded from the AppVar at start and saved
+ * on exit, so revisited molecules skip the solver across sessions.
+ */
+static uint8_t cache_buf[RESULT_CACHE_BYTES];
+static ResultCache cache;
+
+/*
+ * Speculative solve: while the user is still picking atoms, the current
+ * composition is solved in idle time so [2nd] can switch screens without
+ * paying the solve latency. The solve is resumable and is stepped one
+ * work unit at a time until the frame tick is flagged; a unit that runs
+ * past the tick only delays that frame, since the flag stays latched. It
+ * is restarted as soon as the atom list or charge no longer match.
+ */
+
+static Molecule spec_mol;
+static LewisSolver spec_solver;
+static bool spec_started = false;
+static bool spec_done = false;
+
+static bool spec_matches(const Molecule *m)
+{
+    if (!spec_started) return false;
+    if (spec_mol.num_atoms != m->num_atoms || spec_mol.charge != m->charge) return false;
+    for (uint8_t i = 0; i < m->num_atoms; i++) {
+        if (spec_mol.atoms[i].elem != m->atoms[i].elem) return false;
+    }
+    return true;
+}
+
+static void speculative_solve_step(void)
+{
+    if (mol.num_atoms == 0) return;
+
+    if (!spec_matches(&mol)) {
+        memcpy(&spec_mol, &mol, sizeof(spec_mol));
+        spec_started = true;
+        /* A hit is a record decode and a layout copy, no solver work, so it runs unbudgeted. */
+        spec_done = result_cache_lookup(&cache, &spec_mol);
+        if (!spec_done) lewis_solve_begin(&spec_solver, &spec_mol, lewis_scratch());
+    }
+
+    while (!spec_done && !timer_ChkInterrupt(1, TIMER_RELOADED)) {
+        if (lewis_solve_step(&spec_solver, 1) == LEWIS_SOLVE_DONE) {
+            spec_done = true;
+        }
+    }
+}
+
+/*
+ * Solve mol, finishing and reusing the speculative solve when it is still
+ * current, else from the cache or the solver. Either way the result
+ * becomes the most recent cache entry.
+ */
+static void solve_molecule(void)
+{
+    if (spec_matches(&mol)) {
+        while (!spec_done) {
+            spec_done = (lewis_solve_step(&spec_solver, UINT16_MAX) == LEWIS_SOLVE_DONE);
+        }
+        memcpy(&mol, &spec_mol, sizeof(mol));
+        result_cache_insert(&cache, &mol);
+    } else {
+        result_cache_solve(&cache, &mol);
+        memcpy(&spec_mol, &mol, sizeof(spec_mol));
+        spec_started = true;
+        spec_done = true;
+    }
+    molecule_form(&mol, mol.cur_res, &shown_form);
+}
+
+/* Show resonance form r, touching only the fields its delta changes. */
+static void show_form(uint8_t r)
+{
+    resonance_revert(&mol, mol.cur_res, &shown_form);
+    resonance_apply(&mol, r, &shown_form);
+    mol.cur_res = r;
+}
+
+/* Keypad groups read by the UI; a frame only runs when these change or a key is held. */
+#define NUM_KEY_GROUPS 4
+static const uint8_t key_groups[NUM_KEY_GROUPS] = { 1, 2, 6, 7 };
+static uint8_t last_keys[NUM_KEY_GROUPS];
+
+static bool poll_input_event(void)
+{
+    bool changed = false;
+    bool held = false;
+
+    kb_Scan();
+    for (uint8_t g = 0; g < NUM_KEY_GROUPS; g++) {
+        uint8_t keys = (uint8_t)kb_Data[key_groups[g]];
+        if (keys != last_keys[g]) changed = true;
+        if (keys != 0) held = true;
+        last_keys[g] = keys;
+    }
+    return changed || held;
+}
+
+/*
+ * Timer 1 reloads the moment it reaches zero, so the zero itself is only
+ * visible for one 32 kHz tick. The reload flag latches until acknowledged,
+ * so a tick is never missed however late it is checked. No interrupt as
+ * fast as the frame tick is enabled, so idle time is spent polling rather
+ * than halting.
+ */
+static bool frame_tick(void)
+{
+    if (!timer_ChkInterrupt(1, TIMER_RELOADED)) return false;
+    timer_AckInterrupt(1, TIMER_RELOADED);
+    return true;
+}
+
 static void cycle_charge(Molecule *m)
 {
     /* Cycle: 0 -> +1 -> +2 -> -1 -> -2 -> 0 */
@@ -60,7 +195,7 @@ static bool draw_lewis(bool vsepr_force_visible, bool vsepr_card_enabled)
         return false;
     }
 
-    LewisStructure *ls = &mol.res[mol.cur_res];
+    const LewisStructure *ls = &shown_form;
 
     gfx_SetColor(UI_SELECTED_BG);
     gfx_FillRectangle(0, 0, SCR_W, 24);
@@ -117,182 +252,61 @@ static bool draw_lewis(bool vsepr_force_visible, bool vsepr_card_enabled)
 
     gfx_SetTextBGColor(UI_BG);
 
-    int ax[MAX_ATOMS];
-    int ay[MAX_ATOMS];
-
-    if (mol.num_atoms == 1) {
-        ax[0] = LEWIS_CENTER_X;
-        ay[0] = LEWIS_CENTER_Y;
-    } else if (mol.num_atoms == 2) {
-        ax[0] = LEWIS_CENTER_X - BOND_LEN / 2;
-        ay[0] = LEWIS_CENTER_Y;
-        ax[1] = LEWIS_CENTER_X + BOND_LEN / 2;
-        ay[1] = LEWIS_CENTER_Y;
-    } else {
-        bool has_multiple = false;
-        for (uint8_t b = 0; b < ls->num_bonds; b++) {
-            if (ls->bonds[b].order > 1) {
-                has_multiple = true;
-                break;
-            }
-        }
-
-        if (has_multiple && layout_linear_chain(&mol, ls, ax, ay)) {
-            /* Assigned in helper */
-        } else if (layout_tree_from_central(&mol, ls, ax, ay)) {
-            /* Assigned in helper */
-        } else {
-            /* Fallback: simple radial arrangement around central */
-            static const int16_t cos_tbl[12] = {
-                 256,  222,  128,    0, -128, -222,
-                -256, -222, -128,    0,  128,  222
-            };
-            static const int16_t sin_tbl[12] = {
-                   0,  128,  222,  256,  222,  128,
-                   0, -128, -222, -256, -222, -128
-            };
-
-            ax[mol.central] = LEWIS_CENTER_X;
-            ay[mol.central] = LEWIS_CENTER_Y;
-
-            int n_term = mol.num_atoms - 1;
-            int term_idx = 0;
-            for (uint8_t i = 0; i < mol.num_atoms; i++) {
-                if (i == mol.central) continue;
-                int angle_idx = (n_term <= 12) ? ((term_idx * 12) / n_term) : (term_idx % 12);
-                ax[i] = LEWIS_CENTER_X + (int)(cos_tbl[angle_idx] * BOND_LEN / 256);
-                ay[i] = LEWIS_CENTER_Y + (int)(sin_tbl[angle_idx] * BOND_LEN / 256);
-                term_idx++;
-            }
-        }
-    }
+    if (lewis_dl_dirty) {
+        display_list_build(&mol, ls, &mol.layout[mol.cur_res], &lewis_dl);
 
-    /* Draw bonds */
-    for (uint8_t b = 0; b < ls->num_bonds; b++) {
-        uint8_t a = ls->bonds[b].a;
-        uint8_t bb = ls->bonds[b].b;
-        int x1 = ax[a];
-        int y1 = ay[a];
-        int x2 = ax[bb];
-        int y2 = ay[bb];
-
-        gfx_SetColor(COL_BLACK);
-
-        if (ls->bonds[b].order == 1) {
-            gfx_Line(x1, y1, x2, y2);
-        } else if (ls->bonds[b].order == 2) {
-            int dx = x2 - x1;
-            int dy = y2 - y1;
-            int px = -dy;
-            int py = dx;
-            int len = (abs(px) > abs(py)) ? abs(px) : abs(py);
-            if (len == 0) len = 1;
-            int ox = px * 3 / len;
-            int oy = py * 3 / len;
-            gfx_Line(x1 + ox, y1 + oy, x2 + ox, y2 + oy);
-            gfx_Line(x1 - ox, y1 - oy, x2 - ox, y2 - oy);
-        } else if (ls->bonds[b].order == 3) {
-            int dx = x2 - x1;
-            int dy = y2 - y1;
-            int px = -dy;
-            int py = dx;
-            int len = (abs(px) > abs(py)) ? abs(px) : abs(py);
-            if (len == 0) len = 1;
-            int ox = px * 4 / len;
-            int oy = py * 4 / len;
-            gfx_Line(x1, y1, x2, y2);
-            gfx_Line(x1 + ox, y1 + oy, x2 + ox, y2 + oy);
-            gfx_Line(x1 - ox, y1 - oy, x2 - ox, y2 - oy);
+        /* The VSEPR card goes last so it stays on the topmost layer. */
+        DlBox card;
+        if (vsepr_card_enabled && vsepr_card_place(&lewis_dl, vsepr_force_visible, &card)) {
+            display_list_add_card(&lewis_dl, &card);
         }
+        lewis_dl_dirty = false;
     }
 
-    /* Draw atoms (symbols), lone pairs, and formal charges */
-    for (uint8_t i = 0; i < mol.num_atoms; i++) {
-        const Element *e = &elements[mol.atoms[i].elem];
-        int sx = ax[i] - (int)strlen(e->symbol) * 4;
-        int sy = ay[i] - 4;
-
-        int tw = (int)strlen(e->symbol) * 8 + 2;
-        gfx_SetColor(UI_BG);
-        gfx_FillRectangle(sx - 1, sy - 1, tw, 10);
-
-        gfx_SetTextFGColor(UI_TEXT);
-        if (sx >= 0 && sx < SCR_W && sy >= 0 && sy < SCR_H) {
-            safe_print(e->symbol, sx, sy);
-        }
-
-        if (ls->lone_pairs[i] > 0) {
-            gfx_SetColor(UI_TEXT);
-
-            bool slot_used[4] = { false, false, false, false };
-            for (uint8_t b = 0; b < ls->num_bonds; b++) {
-                int other = -1;
-                if (ls->bonds[b].a == i) other = ls->bonds[b].b;
-                else if (ls->bonds[b].b == i) other = ls->bonds[b].a;
-                else continue;
-                int bdx = ax[other] - ax[i];
-                int bdy = ay[other] - ay[i];
-                if (abs(bdy) >= abs(bdx)) {
-                    if (bdy < 0) slot_used[0] = true;
-                    else         slot_used[1] = true;
-                } else {
-                    if (bdx < 0) slot_used[2] = true;
-                    else         slot_used[3] = true;
-                }
-            }
-
-            uint8_t free_slots[4];
-            uint8_t n_free = 0;
-            for (uint8_t s = 0; s < 4; s++) {
-                if (!slot_used[s]) free_slots[n_free++] = s;
+    bool card_drawn = false;
+    for (uint8_t i = 0; i < lewis_dl.count; i++) {
+        const DlPrim *p = &lewis_dl.prims[i];
+
+        switch (p->kind) {
+        case DL_BOND:
+            gfx_SetColor(COL_BLACK);
+            if (p->order != 2) {
+                gfx_Line(p->x1, p->y1, p->x2, p->y2);
             }
-            for (uint8_t s = 0; s < 4 && n_free < 4; s++) {
-                if (slot_used[s]) free_slots[n_free++] = s;
+            if (p->order >= 2) {
+                gfx_Line(p->x1 + p->ox, p->y1 + p->oy, p->x2 + p->ox, p->y2 + p->oy);
+                gfx_Line(p->x1 - p->ox, p->y1 - p->oy, p->x2 - p->ox, p->y2 - p->oy);
             }
+            break;
 
-            int slot_x[4] = { ax[i], ax[i], ax[i] - DOT_DIST, ax[i] + DOT_DIST };
-            int slot_y[4] = { ay[i] - DOT_DIST, ay[i] + DOT_DIST, ay[i], ay[i] };
-
-            for (uint8_t lp = 0; lp < ls->lone_pairs[i] && lp < 4; lp++) {
-                uint8_t s = free_slots[lp];
-                int px = slot_x[s];
-                int py = slot_y[s];
-
-                if (s < 2) {
-                    if (px - 3 >= 0 && px + 3 < SCR_W && py >= 0 && py < SCR_H) {
-                        gfx_FillCircle(px - 3, py, DOT_R);
-                        gfx_FillCircle(px + 3, py, DOT_R);
-                    }
-                } else {
-                    if (px >= 0 && px < SCR_W && py - 3 >= 0 && py + 3 < SCR_H) {
-                        gfx_FillCircle(px, py - 3, DOT_R);
-                        gfx_FillCircle(px, py + 3, DOT_R);
-                    }
-                }
+        case DL_SYMBOL:
+            gfx_SetColor(UI_BG);
+            gfx_FillRectangle(p->box.x, p->box.y, p->box.w, p->box.h);
+            gfx_SetTextFGColor(UI_TEXT);
+            if (p->x1 >= 0 && p->x1 < SCR_W && p->y1 >= 0 && p->y1 < SCR_H) {
+                safe_print(p->text, p->x1, p->y1);
             }
-        }
+            break;
 
-        if (ls->formal_charge[i] != 0) {
-            char fcbuf[6] = "";
-            if (ls->formal_charge[i] > 0) {
-                fcbuf[0] = '+';
-                int_to_str(ls->formal_charge[i], fcbuf + 1);
-            } else {
-                int_to_str(ls->formal_charge[i], fcbuf);
+        case DL_DOTS:
+            if (p->x1 >= 0 && p->x2 < SCR_W && p->y1 >= 0 && p->y2 < SCR_H) {
+                gfx_SetColor(UI_TEXT);
+                gfx_FillCircle(p->x1, p->y1, DOT_R);
+                gfx_FillCircle(p->x2, p->y2, DOT_R);
             }
+            break;
+
+        case DL_CHARGE:
             gfx_SetTextFGColor(UI_TEXT);
-            gfx_SetTextBGColor(UI_BG);
-            int fcx = ax[i] + (int)strlen(e->symbol) * 4 + 2;
-            int fcy = ay[i] - 12;
-            if (fcx >= 0 && fcx < SCR_W - 16 && fcy >= 0 && fcy < SCR_H) {
-                safe_print(fcbuf, fcx, fcy);
+            if (p->x1 >= 0 && p->x1 < SCR_W - 16 && p->y1 >= 0 && p->y1 < SCR_H) {
+                safe_print(p->text, p->x1, p->y1);
             }
-        }
-    }
+            break;
 
-    bool card_drawn = false;
-    if (vsepr_card_enabled) {
-        card_drawn = draw_vsepr_info_card(&mol, ls, ax, ay, vsepr_force_visible);
+        case DL_CARD:
+            card_drawn = draw_vsepr_info_card(&mol, ls, &p->box);
+            break;
+        }
     }
 
     gfx_SetTextFGColor(UI_TEXT);
@@ -311,14 +325,6 @@ static bool draw_lewis(bool vsepr_force_visible, bool vsepr_card_enabled)
         }
     }
 
-    /*
-     * Keep the VSEPR panel on the topmost layer when enabled so it does not
-     * get visually cut by any Lewis-structure render pass.
-     */
-    if (card_drawn && vsepr_card_enabled) {
-        draw_vsepr_info_card(&mol, ls, ax, ay, vsepr_force_visible);
-    }
-
     return card_drawn;
 }
 
@@ -328,12 +334,15 @@ int main(void)
     gfx_SetDrawBuffer();
 
     init_pt_grid();
+    periodic_init_background();
 
     /* Initialize cursor to Carbon (period 2, group 14 -> row 1, col 13) */
     cur_row = 1;
     cur_col = 13;
 
     molecule_reset(&mol);
+    result_cache_init(&cache, cache_buf, sizeof(cache_buf));
+    result_cache_load(&cache, &cache_appvar_store);
 
     bool running = true;
     bool show_lewis = false;
@@ -347,16 +356,32 @@ int main(void)
     timer_Control = TIMER1_ENABLE | TIMER1_32K | TIMER1_0INT | TIMER1_DOWN;
     timer_1_ReloadValue = FRAME_TICKS;
     timer_1_Counter = FRAME_TICKS;
+    timer_AckInterrupt(1, TIMER_RELOADED);
 
     while (running) {
-        while (timer_1_Counter > 0) {}
-        timer_1_Counter = FRAME_TICKS;
+        /* Between frame ticks, spend spare cycles on background work. */
+        if (!frame_tick()) {
+            if (!show_lewis) speculative_solve_step();
+            continue;
+        }
+
+        /*
+         * Skip the frame entirely unless input changed, a key is held for
+         * repeat, a countdown is running, or a buffer still needs its copy
+         * of the last change.
+         */
+        bool input_event = poll_input_event();
+        bool redraw_pending = show_lewis ? (lewis_stale_buffers > 0) : periodic_redraw_pending();
+        if (!input_event && key_delay == 0 && warning_timer == 0 && !redraw_pending) {
+            continue;
+        }
 
-        kb_Scan();
+        bool frame_drawn = true;
 
         if (show_lewis) {
             if (kb_Data[6] & kb_Clear) {
                 show_lewis = false;
+                periodic_invalidate_all();
                 vsepr_force_visible = false;
                 vsepr_card_enabled = true;
                 last_card_drawn = false;
@@ -373,28 +398,37 @@ int main(void)
                     vsepr_card_enabled = false;
                     vsepr_force_visible = false;
                 }
+                invalidate_lewis();
                 key_delay = 8;
             }
 
             if (key_delay == 0 && (kb_Data[2] & kb_Alpha)) {
                 cycle_charge(&mol);
-                generate_resonance(&mol);
+                solve_molecule();
+                invalidate_lewis();
                 key_delay = 8;
             }
 
             if (mol.num_res > 1) {
                 if ((kb_Data[7] & kb_Right) && key_delay == 0) {
-                    mol.cur_res = (mol.cur_res + 1) % mol.num_res;
+                    show_form((uint8_t)((mol.cur_res + 1) % mol.num_res));
+                    invalidate_lewis();
                     key_delay = 8;
                 }
                 if ((kb_Data[7] & kb_Left) && key_delay == 0) {
-                    mol.cur_res = (mol.cur_res == 0) ? mol.num_res - 1 : mol.cur_res - 1;
+                    show_form((uint8_t)((mol.cur_res == 0) ? mol.num_res - 1 : mol.cur_res - 1));
+                    invalidate_lewis();
                     key_delay = 8;
                 }
             }
             if (key_delay > 0) key_delay--;
 
-            last_card_drawn = draw_lewis(vsepr_force_visible, vsepr_card_enabled);
+            if (lewis_stale_buffers > 0) {
+                last_card_drawn = draw_lewis(vsepr_force_visible, vsepr_card_enabled);
+                lewis_stale_buffers--;
+            } else {
+                frame_drawn = false;
+            }
         } else {
             if (kb_Data[1] & kb_Mode) {
                 running = false;
@@ -418,6 +452,7 @@ int main(void)
                         if (ei != ELEM_H && heavy >= MAX_HEAVY) {
                             warning = true;
                             warning_timer = 40;
+                            periodic_invalidate_table();
                         } else {
                             mol.atoms[mol.num_atoms].elem = ei;
                             mol.num_atoms++;
@@ -444,36 +479,47 @@ int main(void)
 
                 if (kb_Data[1] & kb_2nd) {
                     if (mol.num_atoms >= 1) {
-                        generate_resonance(&mol);
+                        solve_molecule();
                         show_lewis = true;
                         vsepr_force_visible = false;
                         vsepr_card_enabled = true;
                         last_card_drawn = false;
+                        invalidate_lewis();
                     }
                     key_delay = 10;
                 }
             }
             if (key_delay > 0) key_delay--;
 
-            draw_periodic_table(&mol, cur_row, cur_col);
+            frame_drawn = draw_periodic_table(&mol, cur_row, cur_col);
 
             if (warning && warning_timer > 0) {
-                gfx_SetColor(UI_ALERT_BG);
-                gfx_FillRectangle(40, 100, 240, 30);
-                gfx_SetColor(UI_ALERT_TEXT);
-                gfx_Rectangle(40, 100, 240, 30);
-                gfx_SetTextScale(1, 1);
-                gfx_SetTextFGColor(UI_ALERT_TEXT);
-                gfx_SetTextBGColor(UI_ALERT_BG);
-                safe_print("Max 6 heavy atoms!", 72, 110);
+                /* The overlay sits above the table, so repaint it whenever the table did. */
+                if (frame_drawn) {
+                    gfx_SetColor(UI_ALERT_BG);
+                    gfx_FillRectangle(40, 100, 240, 30);
+                    gfx_SetColor(UI_ALERT_TEXT);
+                    gfx_Rectangle(40, 100, 240, 30);
+                    gfx_SetTextScale(1, 1);
+                    gfx_SetTextFGColor(UI_ALERT_TEXT);
+                    gfx_SetTextBGColor(UI_ALERT_BG);
+                    safe_print("Max 6 heavy atoms!", 72, 110);
+                }
                 warning_timer--;
-                if (warning_timer == 0) warning = false;
+                if (warning_timer == 0) {
+                    warning = false;
+                    periodic_invalidate_table();
+                }
             }
         }
 
-        gfx_SwapDraw();
+        if (frame_drawn) {
+            gfx_SwapDraw();
+        }
     }
 
+    periodic_free_background();
     gfx_End();
+    result_cache_save(&cache, &cache_appvar_store);
     return 0;
 }
@@ -0,0 +1,104 @@
+#include "occupancy.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+/* Clamp box to the screen and convert it to an inclusive cell range. */
+static bool box_cells(const DlBox *box, int *c0, int *r0, int *c1, int *r1)
+{
+    int x0 = box->x;
+    int y0 = box->y;
+    int x1 = box->x + box->w - 1;
+    int y1 = box->y + box->h - 1;
+
+    if (box->w <= 0 || box->h <= 0) return false;
+    if (x1 < 0 || y1 < 0 || x0 >= SCR_W || y0 >= SCR_H) return false;
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 >= SCR_W) x1 = SCR_W - 1;
+    if (y1 >= SCR_H) y1 = SCR_H - 1;
+
+    *c0 = x0 >> OCC_CELL_SHIFT;
+    *r0 = y0 >> OCC_CELL_SHIFT;
+    *c1 = x1 >> OCC_CELL_SHIFT;
+    *r1 = y1 >> OCC_CELL_SHIFT;
+    return true;
+}
+
+void occupancy_clear(OccupancyGrid *g)
+{
+    memset(g->bits, 0, sizeof(g->bits));
+}
+
+void occupancy_mark(OccupancyGrid *g, const DlBox *box)
+{
+    int c0, r0, c1, r1;
+    if (!box_cells(box, &c0, &r0, &c1, &r1)) return;
+
+    for (int r = r0; r <= r1; r++) {
+        for (int c = c0; c <= c1; c++) {
+            g->bits[r][c >> 3] |= (uint8_t)(1u << (c & 7));
+        }
+    }
+}
+
+void occupancy_finish(OccupancyGrid *g)
+{
+    memset(g->sat[0], 0, sizeof(g->sat[0]));
+
+    for (int r = 0; r < OCC_ROWS; r++) {
+        uint16_t row_sum = 0;
+        g->sat[r + 1][0] = 0;
+        for (int c = 0; c < OCC_COLS; c++) {
+            row_sum = (uint16_t)(row_sum + ((g->bits[r][c >> 3] >> (c & 7)) & 1u));
+            g->sat[r + 1][c + 1] = (uint16_t)(g->sat[r][c + 1] + row_sum);
+        }
+    }
+}
+
+uint16_t occupancy_count(const OccupancyGrid *g, const DlBox *box)
+{
+    int c0, r0, c1, r1;
+    if (!box_cells(box, &c0, &r0, &c1, &r1)) return 0;
+
+    return (uint16_t)(g->sat[r1 + 1][c1 + 1] - g->sat[r0][c1 + 1] - g->sat[r1 + 1][c0] + g->sat[r0][c0]);
+}
+
+static OccupancyGrid card_grid;
+
+/*
+ * Rasterize the structure once, then score every cell-aligned card
+ * position with summed-area lookups. The search starts at the default
+ * spot and walks left and down, so ties keep the card near its usual
+ * place. Only bonds on the central atom count; peripheral bonds may run
+ * under the card.
+ */
+bool vsepr_card_place(const DisplayList *dl, bool force_visible, DlBox *card)
+{
+    occupancy_clear(&card_grid);
+    for (uint8_t i = 0; i < dl->count; i++) {
+        const DlPrim *p = &dl->prims[i];
+        if (p->kind == DL_CARD) continue;
+        if (p->kind == DL_BOND && !(p->flags & DL_FLAG_CENTRAL)) continue;
+        occupancy_mark(&card_grid, &p->box);
+    }
+    occupancy_finish(&card_grid);
+
+    DlBox cand = { VSEPR_CARD_X, VSEPR_CARD_Y, VSEPR_CARD_W, VSEPR_CARD_H };
+    *card = cand;
+    uint16_t best = occupancy_count(&card_grid, &cand);
+
+    for (int y = VSEPR_CARD_Y; y <= VSEPR_CARD_MAX_Y && best > 0; y += OCC_CELL) {
+        for (int x = VSEPR_CARD_X; x >= 0 && best > 0; x -= OCC_CELL) {
+            cand.x = (int16_t)x;
+            cand.y = (int16_t)y;
+            uint16_t score = occupancy_count(&card_grid, &cand);
+            if (score < best) {
+                best = score;
+                *card = cand;
+            }
+        }
+    }
+
+    return force_visible || best < VSEPR_HIDE_OVERLAP_CELLS;
+}
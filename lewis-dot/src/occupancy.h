@@ -0,0 +1,49 @@
+#ifndef OCCUPANCY_H
+#define OCCUPANCY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "display_list.h"
+#include "lewis_model.h"
+
+/*
+ * Coarse screen occupancy: one bit per OCC_CELL x OCC_CELL pixel cell,
+ * plus a summed-area table so the number of occupied cells under any
+ * rectangle is four table reads.
+ */
+#define OCC_CELL_SHIFT 3
+#define OCC_CELL       (1 << OCC_CELL_SHIFT)
+#define OCC_COLS       (SCR_W >> OCC_CELL_SHIFT)
+#define OCC_ROWS       (SCR_H >> OCC_CELL_SHIFT)
+
+typedef struct {
+    uint8_t bits[OCC_ROWS][(OCC_COLS + 7) / 8];
+    uint16_t sat[OCC_ROWS + 1][OCC_COLS + 1];
+} OccupancyGrid;
+
+void occupancy_clear(OccupancyGrid *g);
+
+/* Mark every cell touched by box; off-screen parts are ignored. */
+void occupancy_mark(OccupancyGrid *g, const DlBox *box);
+
+/* Build the summed-area table; call after the last occupancy_mark. */
+void occupancy_finish(OccupancyGrid *g);
+
+/* Occupied cells touched by box. Valid after occupancy_finish. */
+uint16_t occupancy_count(const OccupancyGrid *g, const DlBox *box);
+
+/* VSEPR info card: default box, searched by vsepr_card_place. */
+#define VSEPR_CARD_X 196
+#define VSEPR_CARD_Y 28
+#define VSEPR_CARD_W 120
+#define VSEPR_CARD_H 126
+/* Occupied 8x8 cells under the card before it is hidden (about 1000 px). */
+#define VSEPR_HIDE_OVERLAP_CELLS 16
+/* Lowest card top that keeps the footer line clear. */
+#define VSEPR_CARD_MAX_Y (SCR_H - 12 - VSEPR_CARD_H)
+
+/* Least-covered card box for dl; false when even that hides too much of the structure. */
+bool vsepr_card_place(const DisplayList *dl, bool force_visible, DlBox *card);
+
+#endif
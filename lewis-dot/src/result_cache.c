@@ -0,0 +1,221 @@
+#include "result_cache.h"
+
+#include <string.h>
+
+#include "lewis_engine.h"
+
+/* Bytes of an entry before its body: count, elements, charge, 16-bit body length. */
+#define ENTRY_HEAD(n) ((size_t)(n) + 4u)
+
+static const uint8_t cache_magic[RESULT_CACHE_HEADER] = { 'L', 'D', 'C', RESULT_CACHE_VERSION };
+
+static size_t body_size(const uint8_t *e)
+{
+    return (size_t)e[e[0] + 2] | ((size_t)e[e[0] + 3] << 8);
+}
+
+static size_t entry_size(const uint8_t *e)
+{
+    return ENTRY_HEAD(e[0]) + body_size(e);
+}
+
+/* Reverse len bytes in place. */
+static void reverse_bytes(uint8_t *p, size_t len)
+{
+    while (len > 1) {
+        uint8_t t = p[0];
+        p[0] = p[len - 1];
+        p[len - 1] = t;
+        p++;
+        len -= 2;
+    }
+}
+
+static bool entry_matches(const uint8_t *e, const Molecule *mol)
+{
+    if (e[0] != mol->num_atoms || (int8_t)e[mol->num_atoms + 1] != mol->charge) return false;
+    for (uint8_t i = 0; i < mol->num_atoms; i++) {
+        if (e[i + 1] != mol->atoms[i].elem) return false;
+    }
+    return true;
+}
+
+/* Offset of the entry for mol's composition, or 0 when absent. */
+static size_t find_entry(const ResultCache *c, const Molecule *mol)
+{
+    size_t off = RESULT_CACHE_HEADER;
+    for (uint8_t k = 0; k < c->count; k++) {
+        if (entry_matches(c->buf + off, mol)) return off;
+        off += entry_size(c->buf + off);
+    }
+    return 0;
+}
+
+static void remove_entry(ResultCache *c, size_t off)
+{
+    size_t size = entry_size(c->buf + off);
+    memmove(c->buf + off, c->buf + off + size, c->len - off - size);
+    c->len -= size;
+    c->count--;
+}
+
+static void drop_last(ResultCache *c)
+{
+    size_t last = RESULT_CACHE_HEADER;
+    for (uint8_t k = 1; k < c->count; k++) last += entry_size(c->buf + last);
+    c->len = last;
+    c->count--;
+}
+
+/*
+ * Move the entry at off to the front; later entries keep their order.
+ * Rotating by three reversals needs no entry-sized buffer on the stack.
+ */
+static void promote_entry(ResultCache *c, size_t off)
+{
+    uint8_t *front = c->buf + RESULT_CACHE_HEADER;
+    size_t before = off - RESULT_CACHE_HEADER;
+    size_t size = entry_size(c->buf + off);
+    reverse_bytes(front, before);
+    reverse_bytes(front + before, size);
+    reverse_bytes(front, before + size);
+}
+
+void result_cache_init(ResultCache *c, uint8_t *buf, size_t cap)
+{
+    c->buf = buf;
+    c->cap = cap;
+    c->len = RESULT_CACHE_HEADER;
+    c->count = 0;
+    c->dirty = false;
+    memcpy(buf, cache_magic, RESULT_CACHE_HEADER);
+}
+
+bool result_cache_load(ResultCache *c, const ResultCacheStore *store)
+{
+    size_t len = 0;
+    result_cache_init(c, c->buf, c->cap);
+    if (!store->load(store->ctx, c->buf, c->cap, &len)) {
+        result_cache_init(c, c->buf, c->cap);
+        return false;
+    }
+
+    /* Walk the entries once so later lookups can trust every length. */
+    bool ok = len >= RESULT_CACHE_HEADER && len <= c->cap && memcmp(c->buf, cache_magic, RESULT_CACHE_HEADER) == 0;
+    size_t off = RESULT_CACHE_HEADER;
+    uint8_t count = 0;
+    while (ok && off < len) {
+        const uint8_t *e = c->buf + off;
+        ok = e[0] >= 1 && e[0] <= MAX_ATOMS && off + ENTRY_HEAD(e[0]) <= len &&
+             body_size(e) != 0 && off + entry_size(e) <= len && count < UINT8_MAX;
+        if (ok) {
+            off += entry_size(e);
+            count++;
+        }
+    }
+    if (!ok) {
+        result_cache_init(c, c->buf, c->cap);
+        return false;
+    }
+
+    c->len = len;
+    c->count = count;
+    return true;
+}
+
+bool result_cache_save(ResultCache *c, const ResultCacheStore *store)
+{
+    if (!c->dirty) return true;
+    if (!store->save(store->ctx, c->buf, c->len)) return false;
+    c->dirty = false;
+    return true;
+}
+
+bool result_cache_lookup(ResultCache *c, Molecule *mol)
+{
+    if (mol->num_atoms == 0) return false;
+
+    size_t off = find_entry(c, mol);
+    if (off == 0) return false;
+
+    /* The stored layouts are copied back, so a hit never runs layout. */
+    const uint8_t *e = c->buf + off;
+    size_t body = body_size(e);
+    Molecule hit;
+    LewisBitReader r;
+    lewis_bits_reader_init(&r, e + ENTRY_HEAD(e[0]), body);
+    bool ok = lewis_pack_read_forms(&r, &hit) && entry_matches(e, &hit) &&
+              body - (r.bitpos >> 3) == (size_t)hit.num_res * hit.num_atoms * RESULT_CACHE_LAYOUT_BYTES;
+    if (!ok) {
+        remove_entry(c, off);
+        c->dirty = true;
+        return false;
+    }
+    const uint8_t *p = e + ENTRY_HEAD(e[0]) + (r.bitpos >> 3);
+    for (uint8_t f = 0; f < hit.num_res; f++) {
+        AtomLayout *lay = &hit.layout[f];
+        for (uint8_t i = 0; i < hit.num_atoms; i++) {
+            lay->x[i] = (int16_t)(p[0] | (p[1] << 8));
+            lay->y[i] = (int16_t)(p[2] | (p[3] << 8));
+            lay->lp_slots[i] = p[4];
+            p += RESULT_CACHE_LAYOUT_BYTES;
+        }
+    }
+
+    memcpy(mol, &hit, sizeof(*mol));
+    if (off != RESULT_CACHE_HEADER) {
+        promote_entry(c, off);
+        c->dirty = true;
+    }
+    return true;
+}
+
+void result_cache_insert(ResultCache *c, const Molecule *mol)
+{
+    uint8_t record[LEWIS_PACK_MAX_BYTES];
+    size_t rec_len = lewis_pack(mol, record, sizeof(record));
+    if (rec_len == 0) return;
+
+    size_t off = find_entry(c, mol);
+    if (off != 0) remove_entry(c, off);
+
+    size_t body = rec_len + (size_t)mol->num_res * mol->num_atoms * RESULT_CACHE_LAYOUT_BYTES;
+    size_t size = ENTRY_HEAD(mol->num_atoms) + body;
+    if (RESULT_CACHE_HEADER + size > c->cap) return;
+
+    /* Evict from the tail until the new entry fits. */
+    while (c->len + size > c->cap || c->count == UINT8_MAX) drop_last(c);
+
+    uint8_t *e = c->buf + RESULT_CACHE_HEADER;
+    memmove(e + size, e, c->len - RESULT_CACHE_HEADER);
+    e[0] = mol->num_atoms;
+    for (uint8_t i = 0; i < mol->num_atoms; i++) e[i + 1] = mol->atoms[i].elem;
+    e[mol->num_atoms + 1] = (uint8_t)mol->charge;
+    e[mol->num_atoms + 2] = (uint8_t)body;
+    e[mol->num_atoms + 3] = (uint8_t)(body >> 8);
+    uint8_t *p = e + ENTRY_HEAD(mol->num_atoms);
+    memcpy(p, record, rec_len);
+    p += rec_len;
+    for (uint8_t f = 0; f < mol->num_res; f++) {
+        const AtomLayout *lay = &mol->layout[f];
+        for (uint8_t i = 0; i < mol->num_atoms; i++) {
+            p[0] = (uint8_t)lay->x[i];
+            p[1] = (uint8_t)((uint16_t)lay->x[i] >> 8);
+            p[2] = (uint8_t)lay->y[i];
+            p[3] = (uint8_t)((uint16_t)lay->y[i] >> 8);
+            p[4] = lay->lp_slots[i];
+            p += RESULT_CACHE_LAYOUT_BYTES;
+        }
+    }
+    c->len += size;
+    c->count++;
+    c->dirty = true;
+}
+
+bool result_cache_solve(ResultCache *c, Molecule *mol)
+{
+    if (result_cache_lookup(c, mol)) return true;
+    generate_resonance(mol);
+    result_cache_insert(c, mol);
+    return false;
+}
@@ -0,0 +1,80 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "lewis_model.h"
+#include "lewis_pack.h"
+
+/*
+ * Recently solved molecules as lewis_pack records in one caller-supplied
+ * buffer, most recently used first, so a repeated composition skips
+ * generate_resonance(). The buffer is also the persisted image:
+ *
+ *   "LDC" + RESULT_CACHE_VERSION
+ *   per entry: atom count, element index per atom (input order), charge,
+ *              16-bit body length, then the body: a lewis_pack record
+ *              followed by RESULT_CACHE_LAYOUT_BYTES per atom per form
+ *              (int16 x, int16 y, lp_slots)
+ *
+ * Entries match on the atoms in input order and the charge, as the
+ * speculative solve does, so a hit restores exactly what a fresh solve
+ * would produce. Layouts are stored, not recomputed, so a hit costs a
+ * decode and a copy. When an insert does not fit, least recently used entries
+ * are dropped from the tail. Storage is reached through ResultCacheStore:
+ * an AppVar on the calculator (cache_appvar.c), a file in host tests.
+ */
+#define RESULT_CACHE_VERSION  2
+#define RESULT_CACHE_HEADER   4
+#define RESULT_CACHE_LAYOUT_BYTES 5
+#define RESULT_CACHE_BYTES    2048  /* device buffer and AppVar size bound */
+
+#if LEWIS_PACK_MAX_BYTES + MAX_RESONANCE * MAX_ATOMS * RESULT_CACHE_LAYOUT_BYTES > 0xFFFF
+#error "cache entry body length does not fit 16 bits"
+#endif
+
+/*
+ * load copies at most cap bytes of the stored image into buf and sets
+ * *len; false when there is none. save replaces the stored image.
+ */
+typedef bool (*ResultCacheLoadFn)(void *ctx, uint8_t *buf, size_t cap, size_t *len);
+typedef bool (*ResultCacheSaveFn)(void *ctx, const uint8_t *buf, size_t len);
+
+typedef struct {
+    ResultCacheLoadFn load;
+    ResultCacheSaveFn save;
+    void *ctx;
+} ResultCacheStore;
+
+typedef struct {
+    uint8_t *buf;
+    size_t cap;
+    size_t len;      /* header plus entries in use */
+    uint8_t count;   /* entries */
+    bool dirty;      /* changed since the last load or save */
+} ResultCache;
+
+/* Empty cache over buf; cap must exceed RESULT_CACHE_HEADER. */
+void result_cache_init(ResultCache *c, uint8_t *buf, size_t cap);
+
+/* Replace the contents with the stored image. False (and empty) when missing or malformed. */
+bool result_cache_load(ResultCache *c, const ResultCacheStore *store);
+
+/* Write the image back when it changed. False on a store failure. */
+bool result_cache_save(ResultCache *c, const ResultCacheStore *store);
+
+/*
+ * On a hit, replace mol with the stored result and make it the most
+ * recent entry. On a miss mol is left as it is.
+ */
+bool result_cache_lookup(ResultCache *c, Molecule *mol);
+
+/* Add or refresh the entry for a solved mol as the most recent one. */
+void result_cache_insert(ResultCache *c, const Molecule *mol);
+
+/* Cached result when present, else generate_resonance() and insert. True on a hit. */
+bool result_cache_solve(ResultCache *c, Molecule *mol);
+
+#endif
@@ -69,13 +69,101 @@ void move_cursor(uint8_t *cur_row, uint8_t *cur_col, int dr, int dc)
     }
 }
 
-void draw_periodic_table(const Molecule *mol, uint8_t cur_row, uint8_t cur_col)
+/*
+ * Retained state for the periodic-table screen. Both graphx buffers keep
+ * their own dirty set because a region repainted into the back buffer is
+ * still stale in the front buffer until the next swap.
+ */
+#define PT_REGION_BACKGROUND 0x01
+#define PT_REGION_INFO       0x02
+#define PT_REGION_SEL        0x04
+#define PT_REGION_TABLE      0x08
+#define PT_REGION_CARD       0x10
+#define PT_REGION_FOOTER     0x20
+#define PT_REGION_ALL        0x3F
+
+#define PT_TABLE_BOTTOM      ((CARD_Y + CARD_H) > (PT_Y + PT_ROWS * PT_CELL_H) ? (CARD_Y + CARD_H) : (PT_Y + PT_ROWS * PT_CELL_H))
+#define PT_CELL_MASK_BYTES   ((NUM_ELEMENTS + 7) / 8)
+
+typedef struct {
+    uint8_t regions[2];
+    uint8_t cells[2][PT_CELL_MASK_BYTES];
+    uint8_t back;
+
+    bool    valid;
+    uint8_t cur_row;
+    uint8_t cur_col;
+    uint8_t num_atoms;
+    int8_t  charge;
+    uint8_t atoms[MAX_ATOMS];
+} PeriodicView;
+
+static PeriodicView view;
+
+static void mark_regions(uint8_t regions)
 {
-    gfx_FillScreen(UI_BG);
+    view.regions[0] |= regions;
+    view.regions[1] |= regions;
+}
 
-    uint8_t sel_elem = pt_grid[cur_row][cur_col];
+static void mark_cell(uint8_t elem_idx)
+{
+    if (elem_idx == ELEM_NONE) return;
+    uint8_t bit = (uint8_t)(1u << (elem_idx & 7));
+    view.cells[0][elem_idx >> 3] |= bit;
+    view.cells[1][elem_idx >> 3] |= bit;
+}
+
+bool periodic_redraw_pending(void)
+{
+    if (!view.valid) return true;
+    if ((view.regions[0] | view.regions[1]) != 0) return true;
+    for (uint8_t i = 0; i < PT_CELL_MASK_BYTES; i++) {
+        if ((view.cells[0][i] | view.cells[1][i]) != 0) return true;
+    }
+    return false;
+}
 
-    /* Top info bar */
+void periodic_invalidate_all(void)
+{
+    view.valid = false;
+}
+
+void periodic_invalidate_table(void)
+{
+    mark_regions(PT_REGION_TABLE | PT_REGION_CARD);
+}
+
+/* Compare the molecule and cursor against what was last drawn. */
+static void track_changes(const Molecule *mol, uint8_t cur_row, uint8_t cur_col)
+{
+    if (!view.valid) {
+        mark_regions(PT_REGION_ALL);
+        view.valid = true;
+    } else {
+        if (cur_row != view.cur_row || cur_col != view.cur_col) {
+            mark_cell(pt_grid[view.cur_row][view.cur_col]);
+            mark_cell(pt_grid[cur_row][cur_col]);
+            mark_regions(PT_REGION_INFO | PT_REGION_CARD);
+        }
+        if (mol->num_atoms != view.num_atoms ||
+            mol->charge != view.charge ||
+            memcmp(view.atoms, mol->atoms, mol->num_atoms) != 0) {
+            mark_regions(PT_REGION_SEL);
+        }
+    }
+
+    view.cur_row = cur_row;
+    view.cur_col = cur_col;
+    view.num_atoms = mol->num_atoms;
+    view.charge = mol->charge;
+    for (uint8_t i = 0; i < mol->num_atoms; i++) {
+        view.atoms[i] = mol->atoms[i].elem;
+    }
+}
+
+static void draw_info_bar(uint8_t sel_elem)
+{
     gfx_SetColor(UI_SELECTED_BG);
     gfx_FillRectangle(0, INFO_Y, SCR_W, INFO_H);
     gfx_SetTextFGColor(UI_SELECTED_TEXT);
@@ -91,8 +179,10 @@ void draw_periodic_table(const Molecule *mol, uint8_t cur_row, uint8_t cur_col)
         append_int(buf, sizeof(buf), e->bond_cap);
         safe_print(buf, 60, 18);
     }
+}
 
-    /* Selected atoms bar */
+static void draw_selection_bar(const Molecule *mol)
+{
     gfx_SetColor(UI_SELECTED_BG);
     gfx_FillRectangle(0, SEL_Y, SCR_W, SEL_H);
     gfx_SetTextFGColor(UI_SELECTED_TEXT);
@@ -156,91 +246,256 @@ void draw_periodic_table(const Molecule *mol, uint8_t cur_row, uint8_t cur_col)
         gfx_SetTextBGColor(UI_SELECTED_BG);
         safe_print(cbuf, SCR_W - 56, SEL_Y + 22);
     }
+}
+
+static void draw_cell(int r, int c, bool is_selected)
+{
+    uint8_t ei = pt_grid[r][c];
+    int pt_x0 = (SCR_W - PT_COLS * PT_CELL_W) / 2;
+    int cx = pt_x0 + c * PT_CELL_W;
+    int cy = PT_Y + r * PT_CELL_H;
+    uint8_t cell_bg = is_selected ? UI_SELECTED_BG : UI_SURFACE;
+    uint8_t cell_text = is_selected ? UI_SELECTED_TEXT : UI_TEXT;
+
+    gfx_SetColor(cell_bg);
+    gfx_FillRectangle(cx + 1, cy + 1, PT_CELL_W - 2, PT_CELL_H - 2);
+    gfx_SetColor(UI_BORDER);
+    gfx_Rectangle(cx, cy, PT_CELL_W, PT_CELL_H);
+
+    if (is_selected) {
+        gfx_SetColor(UI_SELECTED_TEXT);
+        gfx_Rectangle(cx + 1, cy + 1, PT_CELL_W - 2, PT_CELL_H - 2);
+    }
+
+    gfx_SetTextFGColor(cell_text);
+    gfx_SetTextBGColor(cell_bg);
+    int tx = cx + (PT_CELL_W - (int)strlen(elements[ei].symbol) * 8) / 2;
+    int ty = cy + (PT_CELL_H - 8) / 2;
+    if (tx >= 0 && tx < SCR_W && ty >= 0 && ty < SCR_H) {
+        safe_print(elements[ei].symbol, tx, ty);
+    }
+}
+
+/*
+ * Pre-rendered grid background. A gfx_sprite_t is at most 255 pixels wide,
+ * so the static table is captured as runs of occupied columns (groups 1-2
+ * and 13-18 in this table) rather than one 306-pixel sprite.
+ */
+#define PT_SPAN_MAX_COLS (255 / PT_CELL_W)
+#define PT_MAX_SPANS     4
+
+typedef struct {
+    gfx_sprite_t *sprite;
+    int x;
+    uint8_t first_col;
+    uint8_t num_cols;
+} TableSpan;
+
+static TableSpan table_spans[PT_MAX_SPANS];
+static uint8_t n_table_spans = 0;
+
+static bool column_occupied(uint8_t c)
+{
+    for (uint8_t r = 0; r < PT_ROWS; r++) {
+        if (pt_grid[r][c] != ELEM_NONE) return true;
+    }
+    return false;
+}
+
+void periodic_free_background(void)
+{
+    for (uint8_t i = 0; i < n_table_spans; i++) {
+        free(table_spans[i].sprite);
+        table_spans[i].sprite = NULL;
+    }
+    n_table_spans = 0;
+}
+
+bool periodic_init_background(void)
+{
+    int pt_x0 = (SCR_W - PT_COLS * PT_CELL_W) / 2;
+
+    periodic_free_background();
 
-    /* Periodic table grid */
-    int pt_total_w = PT_COLS * PT_CELL_W;
-    int pt_x0 = (SCR_W - pt_total_w) / 2;
+    uint8_t c = 0;
+    while (c < PT_COLS) {
+        if (!column_occupied(c)) {
+            c++;
+            continue;
+        }
+
+        uint8_t first = c;
+        while (c < PT_COLS && column_occupied(c) && (c - first) < PT_SPAN_MAX_COLS) {
+            c++;
+        }
+
+        if (n_table_spans >= PT_MAX_SPANS) {
+            periodic_free_background();
+            return false;
+        }
+
+        TableSpan *span = &table_spans[n_table_spans];
+        span->first_col = first;
+        span->num_cols = (uint8_t)(c - first);
+        span->x = pt_x0 + first * PT_CELL_W;
+        span->sprite = gfx_MallocSprite(span->num_cols * PT_CELL_W, PT_ROWS * PT_CELL_H);
+        if (span->sprite == NULL) {
+            periodic_free_background();
+            return false;
+        }
+        n_table_spans++;
+    }
+
+    /* Render every cell unselected into the draw buffer once, then capture it. */
+    for (uint8_t i = 0; i < n_table_spans; i++) {
+        const TableSpan *span = &table_spans[i];
+        gfx_SetColor(UI_BG);
+        gfx_FillRectangle(span->x, PT_Y, span->num_cols * PT_CELL_W, PT_ROWS * PT_CELL_H);
+        for (uint8_t r = 0; r < PT_ROWS; r++) {
+            for (uint8_t sc = span->first_col; sc < span->first_col + span->num_cols; sc++) {
+                if (pt_grid[r][sc] != ELEM_NONE) draw_cell(r, sc, false);
+            }
+        }
+        gfx_GetSprite(span->sprite, span->x, PT_Y);
+    }
+
+    view.valid = false;
+    return true;
+}
+
+/* Restore one unselected cell by blitting its span sprite through a cell-sized clip window. */
+static bool blit_cell_background(int r, int c)
+{
+    for (uint8_t i = 0; i < n_table_spans; i++) {
+        const TableSpan *span = &table_spans[i];
+        if (c < span->first_col || c >= span->first_col + span->num_cols) continue;
+
+        int cx = span->x + (c - span->first_col) * PT_CELL_W;
+        int cy = PT_Y + r * PT_CELL_H;
+        gfx_SetClipRegion(cx, cy, cx + PT_CELL_W, cy + PT_CELL_H);
+        gfx_Sprite(span->sprite, span->x, PT_Y);
+        gfx_SetClipRegion(0, 0, SCR_W, SCR_H);
+        return true;
+    }
+    return false;
+}
+
+/*
+ * Paint the grid. A full repaint blits the background spans and overlays
+ * the cursor cell; otherwise only dirty cells are restored or highlighted.
+ */
+static void draw_cells(const uint8_t dirty[PT_CELL_MASK_BYTES], bool all_cells, uint8_t cur_row, uint8_t cur_col)
+{
+    if (all_cells && n_table_spans > 0) {
+        for (uint8_t i = 0; i < n_table_spans; i++) {
+            gfx_Sprite_NoClip(table_spans[i].sprite, table_spans[i].x, PT_Y);
+        }
+        draw_cell(cur_row, cur_col, true);
+        return;
+    }
 
     for (int r = 0; r < PT_ROWS; r++) {
         for (int c = 0; c < PT_COLS; c++) {
             uint8_t ei = pt_grid[r][c];
             if (ei == ELEM_NONE) continue;
+            if (!all_cells && !(dirty[ei >> 3] & (1u << (ei & 7)))) continue;
 
-            int cx = pt_x0 + c * PT_CELL_W;
-            int cy = PT_Y + r * PT_CELL_H;
             bool is_selected = (r == cur_row && c == cur_col);
-            uint8_t cell_bg = is_selected ? UI_SELECTED_BG : UI_SURFACE;
-            uint8_t cell_text = is_selected ? UI_SELECTED_TEXT : UI_TEXT;
+            if (is_selected || !blit_cell_background(r, c)) {
+                draw_cell(r, c, is_selected);
+            }
+        }
+    }
+}
 
-            gfx_SetColor(cell_bg);
-            gfx_FillRectangle(cx + 1, cy + 1, PT_CELL_W - 2, PT_CELL_H - 2);
-            gfx_SetColor(UI_BORDER);
-            gfx_Rectangle(cx, cy, PT_CELL_W, PT_CELL_H);
+static void draw_element_card(uint8_t sel_elem)
+{
+    if (sel_elem == ELEM_NONE) return;
 
-            if (is_selected) {
-                gfx_SetColor(UI_SELECTED_TEXT);
-                gfx_Rectangle(cx + 1, cy + 1, PT_CELL_W - 2, PT_CELL_H - 2);
-            }
+    const Element *e = &elements[sel_elem];
 
-            gfx_SetTextFGColor(cell_text);
-            gfx_SetTextBGColor(cell_bg);
-            int tx = cx + (PT_CELL_W - (int)strlen(elements[ei].symbol) * 8) / 2;
-            int ty = cy + (PT_CELL_H - 8) / 2;
-            if (tx >= 0 && tx < SCR_W && ty >= 0 && ty < SCR_H) {
-                safe_print(elements[ei].symbol, tx, ty);
-            }
-        }
+    gfx_SetColor(UI_BORDER);
+    gfx_FillRectangle(CARD_X, CARD_Y, CARD_W, CARD_H);
+    gfx_SetColor(UI_SURFACE);
+    gfx_FillRectangle(CARD_X + 2, CARD_Y + 2, CARD_W - 4, CARD_H - 4);
+    gfx_SetColor(UI_BORDER);
+    gfx_Rectangle(CARD_X, CARD_Y, CARD_W, CARD_H);
+
+    gfx_SetTextFGColor(UI_TEXT);
+    gfx_SetTextBGColor(UI_SURFACE);
+    {
+        char abuf[4];
+        int_to_str(e->atomic_num, abuf);
+        safe_print(abuf, CARD_X + 5, CARD_Y + 5);
     }
 
-    /* Element info card */
-    if (sel_elem != ELEM_NONE) {
-        const Element *e = &elements[sel_elem];
+    gfx_SetTextScale(3, 3);
+    {
+        int sym_w = (int)strlen(e->symbol) * 24;
+        int sx = CARD_X + (CARD_W - sym_w) / 2;
+        int sy = CARD_Y + 16;
+        gfx_SetTextFGColor(UI_TEXT);
+        gfx_SetTextBGColor(UI_SURFACE);
+        safe_print(e->symbol, sx, sy);
+    }
+    gfx_SetTextScale(1, 1);
 
-        gfx_SetColor(UI_BORDER);
-        gfx_FillRectangle(CARD_X, CARD_Y, CARD_W, CARD_H);
-        gfx_SetColor(UI_SURFACE);
-        gfx_FillRectangle(CARD_X + 2, CARD_Y + 2, CARD_W - 4, CARD_H - 4);
-        gfx_SetColor(UI_BORDER);
-        gfx_Rectangle(CARD_X, CARD_Y, CARD_W, CARD_H);
+    {
+        int name_w = (int)strlen(e->name) * 8;
+        int nx = CARD_X + (CARD_W - name_w) / 2;
+        gfx_SetTextFGColor(UI_TEXT);
+        gfx_SetTextBGColor(UI_SURFACE);
+        safe_print(e->name, nx, CARD_Y + CARD_H - 22);
+    }
 
+    {
+        char vbuf[12] = "e-: ";
+        append_int(vbuf, sizeof(vbuf), e->valence);
+        int vw = (int)strlen(vbuf) * 8;
         gfx_SetTextFGColor(UI_TEXT);
         gfx_SetTextBGColor(UI_SURFACE);
-        {
-            char abuf[4];
-            int_to_str(e->atomic_num, abuf);
-            safe_print(abuf, CARD_X + 5, CARD_Y + 5);
-        }
+        safe_print(vbuf, CARD_X + (CARD_W - vw) / 2, CARD_Y + CARD_H - 11);
+    }
+}
 
-        gfx_SetTextScale(3, 3);
-        {
-            int sym_w = (int)strlen(e->symbol) * 24;
-            int sx = CARD_X + (CARD_W - sym_w) / 2;
-            int sy = CARD_Y + 16;
-            gfx_SetTextFGColor(UI_TEXT);
-            gfx_SetTextBGColor(UI_SURFACE);
-            safe_print(e->symbol, sx, sy);
-        }
-        gfx_SetTextScale(1, 1);
+bool draw_periodic_table(const Molecule *mol, uint8_t cur_row, uint8_t cur_col)
+{
+    track_changes(mol, cur_row, cur_col);
 
-        {
-            int name_w = (int)strlen(e->name) * 8;
-            int nx = CARD_X + (CARD_W - name_w) / 2;
-            gfx_SetTextFGColor(UI_TEXT);
-            gfx_SetTextBGColor(UI_SURFACE);
-            safe_print(e->name, nx, CARD_Y + CARD_H - 22);
-        }
+    uint8_t back = view.back;
+    uint8_t regions = view.regions[back];
+    bool any_cells = false;
+    for (uint8_t i = 0; i < PT_CELL_MASK_BYTES; i++) {
+        if (view.cells[back][i] != 0) any_cells = true;
+    }
+    if (regions == 0 && !any_cells) {
+        return false;
+    }
 
-        {
-            char vbuf[12] = "e-: ";
-            append_int(vbuf, sizeof(vbuf), e->valence);
-            int vw = (int)strlen(vbuf) * 8;
-            gfx_SetTextFGColor(UI_TEXT);
-            gfx_SetTextBGColor(UI_SURFACE);
-            safe_print(vbuf, CARD_X + (CARD_W - vw) / 2, CARD_Y + CARD_H - 11);
-        }
+    uint8_t sel_elem = pt_grid[cur_row][cur_col];
+
+    if (regions & PT_REGION_BACKGROUND) {
+        gfx_FillScreen(UI_BG);
+    } else if (regions & PT_REGION_TABLE) {
+        gfx_SetColor(UI_BG);
+        gfx_FillRectangle(0, PT_Y, SCR_W, PT_TABLE_BOTTOM - PT_Y);
     }
 
-    gfx_SetTextFGColor(UI_TEXT);
-    gfx_SetTextBGColor(UI_BG);
-    safe_print("[enter]add [del]undo [alpha]chg [2nd]go", 4, SCR_H - 10);
+    if (regions & PT_REGION_INFO) draw_info_bar(sel_elem);
+    if (regions & PT_REGION_SEL) draw_selection_bar(mol);
+
+    draw_cells(view.cells[back], (regions & PT_REGION_TABLE) != 0, cur_row, cur_col);
+
+    if (regions & PT_REGION_CARD) draw_element_card(sel_elem);
+
+    if (regions & PT_REGION_FOOTER) {
+        gfx_SetTextFGColor(UI_TEXT);
+        gfx_SetTextBGColor(UI_BG);
+        safe_print("[enter]add [del]undo [alpha]chg [2nd]go", 4, SCR_H - 10);
+    }
+
+    view.regions[back] = 0;
+    memset(view.cells[back], 0, sizeof(view.cells[back]));
+    view.back ^= 1;
+    return true;
 }
@@ -1,11 +1,28 @@
 #ifndef UI_PERIODIC_H
 #define UI_PERIODIC_H
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #include "lewis_model.h"
 
 void move_cursor(uint8_t *cur_row, uint8_t *cur_col, int dr, int dc);
-void draw_periodic_table(const Molecule *mol, uint8_t cur_row, uint8_t cur_col);
+
+/*
+ * Pre-render the static grid into off-screen sprites. Call once after
+ * gfx_Begin(); returns false (and keeps drawing cells directly) when the
+ * sprites cannot be allocated.
+ */
+bool periodic_init_background(void);
+void periodic_free_background(void);
+
+/*
+ * Repaints only the regions that changed since the last call and returns
+ * false when the back buffer is already current (caller skips the swap).
+ */
+bool draw_periodic_table(const Molecule *mol, uint8_t cur_row, uint8_t cur_col);
+bool periodic_redraw_pending(void);
+void periodic_invalidate_all(void);
+void periodic_invalidate_table(void);
 
 #endif
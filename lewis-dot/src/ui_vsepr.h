@@ -3,8 +3,10 @@
 
 #include <stdbool.h>
 
+#include "display_list.h"
 #include "lewis_model.h"
+#include "occupancy.h"
 
-bool draw_vsepr_info_card(const Molecule *mol, const LewisStructure *ls, const int ax[MAX_ATOMS], const int ay[MAX_ATOMS], bool force_visible);
+bool draw_vsepr_info_card(const Molecule *mol, const LewisStructure *ls, const DlBox *card);
 
 #endif
@@ -2,7 +2,17 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "../src/display_list.h"
+#include "../src/layout.h"
+#include "../src/occupancy.h"
+#include "../src/result_cache.h"
+#include "../tools/jsonl_writer.h"
+#include "../tools/out_sink.h"
+#include "../tools/sdf_writer.h"
+#include "../tools/smiles.h"
+#include "../tools/svg_writer.h"
 #include "../src/lewis_engine.h"
+#include "../src/lewis_pack.h"
 #include "../src/lewis_model.h"
 
 #define ELEM_B_IDX   4
@@ -57,6 +67,19 @@ static int central_bond_count_by_order(const Molecule *mol, const LewisStructure
     return count;
 }
 
+/*
+ * Form r of mol unpacked, formal charges included. Each call fills the
+ * next of eight slots, so a few forms can be compared side by side.
+ */
+static LewisStructure *form_of(const Molecule *mol, uint8_t r)
+{
+    static LewisStructure slots[8];
+    static uint8_t next;
+    LewisStructure *ls = &slots[next++ & 7u];
+    molecule_form(mol, r, ls);
+    return ls;
+}
+
 static bool structures_equal(const Molecule *mol, const LewisStructure *a, const LewisStructure *b)
 {
     if (a->num_bonds != b->num_bonds) return false;
@@ -75,7 +98,7 @@ static bool all_resonance_unique(const Molecule *mol)
 {
     for (uint8_t i = 0; i < mol->num_res; i++) {
         for (uint8_t j = i + 1; j < mol->num_res; j++) {
-            if (structures_equal(mol, &mol->res[i], &mol->res[j])) {
+            if (structures_equal(mol, form_of(mol, i), form_of(mol, j))) {
                 return false;
             }
         }
@@ -86,7 +109,7 @@ static bool all_resonance_unique(const Molecule *mol)
 static bool all_formal_charge_sums_match(const Molecule *mol)
 {
     for (uint8_t i = 0; i < mol->num_res; i++) {
-        if (formal_charge_sum(mol, &mol->res[i]) != mol->charge) {
+        if (formal_charge_sum(mol, form_of(mol, i)) != mol->charge) {
             return false;
         }
     }
@@ -144,7 +167,7 @@ static bool test_vsepr_co2(void)
     build_and_generate(&mol, 0, atoms, (uint8_t)(sizeof(atoms) / sizeof(atoms[0])));
 
     if (!success_invariants(&mol)) return false;
-    if (!lewis_get_vsepr_info(&mol, &mol.res[mol.cur_res], &info)) return false;
+    if (!lewis_get_vsepr_info(&mol, form_of(&mol, mol.cur_res), &info)) return false;
     return vsepr_info_matches(&info, 2, 2, 0, "Linear", "Linear", "sp");
 }
 
@@ -156,7 +179,7 @@ static bool test_vsepr_nitrate(void)
     build_and_generate(&mol, -1, atoms, (uint8_t)(sizeof(atoms) / sizeof(atoms[0])));
 
     if (!success_invariants(&mol)) return false;
-    if (!lewis_get_vsepr_info(&mol, &mol.res[mol.cur_res], &info)) return false;
+    if (!lewis_get_vsepr_info(&mol, form_of(&mol, mol.cur_res), &info)) return false;
     return vsepr_info_matches(&info, 3, 3, 0, "Trigonal Planar", "Trigonal Planar", "sp2");
 }
 
@@ -168,7 +191,7 @@ static bool test_vsepr_ammonium(void)
     build_and_generate(&mol, 1, atoms, (uint8_t)(sizeof(atoms) / sizeof(atoms[0])));
 
     if (!success_invariants(&mol)) return false;
-    if (!lewis_get_vsepr_info(&mol, &mol.res[mol.cur_res], &info)) return false;
+    if (!lewis_get_vsepr_info(&mol, form_of(&mol, mol.cur_res), &info)) return false;
     return vsepr_info_matches(&info, 4, 4, 0, "Tetrahedral", "Tetrahedral", "sp3");
 }
 
@@ -180,7 +203,7 @@ static bool test_vsepr_water(void)
     build_and_generate(&mol, 0, atoms, (uint8_t)(sizeof(atoms) / sizeof(atoms[0])));
 
     if (!success_invariants(&mol)) return false;
-    if (!lewis_get_vsepr_info(&mol, &mol.res[mol.cur_res], &info)) return false;
+    if (!lewis_get_vsepr_info(&mol, form_of(&mol, mol.cur_res), &info)) return false;
     return vsepr_info_matches(&info, 4, 2, 2, "Tetrahedral", "Bent", "sp3");
 }
 
@@ -192,7 +215,7 @@ static bool test_vsepr_pcl5(void)
     build_and_generate(&mol, 0, atoms, (uint8_t)(sizeof(atoms) / sizeof(atoms[0])));
 
     if (!success_invariants(&mol)) return false;
-    if (!lewis_get_vsepr_info(&mol, &mol.res[mol.cur_res], &info)) return false;
+    if (!lewis_get_vsepr_info(&mol, form_of(&mol, mol.cur_res), &info)) return false;
     return vsepr_info_matches(&info, 5, 5, 0, "Trigonal Bipyramidal", "Trigonal Bipyramidal", "sp3d");
 }
 
@@ -204,7 +227,7 @@ static bool test_vsepr_sf6(void)
     build_and_generate(&mol, 0, atoms, (uint8_t)(sizeof(atoms) / sizeof(atoms[0])));
 
     if (!success_invariants(&mol)) return false;
-    if (!lewis_get_vsepr_info(&mol, &mol.res[mol.cur_res], &info)) return false;
+    if (!lewis_get_vsepr_info(&mol, form_of(&mol, mol.cur_res), &info)) return false;
     return vsepr_info_matches(&info, 6, 6, 0, "Octahedral", "Octahedral", "sp3d2");
 }
 
@@ -216,7 +239,7 @@ static bool test_vsepr_h2_no_null(void)
     build_and_generate(&mol, 0, atoms, (uint8_t)(sizeof(atoms) / sizeof(atoms[0])));
 
     if (!success_invariants(&mol)) return false;
-    if (!lewis_get_vsepr_info(&mol, &mol.res[mol.cur_res], &info)) return false;
+    if (!lewis_get_vsepr_info(&mol, form_of(&mol, mol.cur_res), &info)) return false;
     if (!vsepr_info_matches(&info, 1, 1, 0, "Linear", "Linear", "s")) return false;
     return true;
 }
@@ -252,7 +275,7 @@ static bool test_co2(void)
     if (mol.num_res != 1) return false;
     if (mol.atoms[mol.central].elem != ELEM_C) return false;
 
-    LewisStructure *ls = &mol.res[0];
+    LewisStructure *ls = form_of(&mol, 0);
     if (bond_order_sum(ls, mol.central) != 4) return false;
     if (ls->lone_pairs[mol.central] != 0) return false;
     if (formal_charge_sum(&mol, ls) != 0) return false;
@@ -269,7 +292,7 @@ static bool test_h2_basic(void)
     if (!success_invariants(&mol)) return false;
     if (mol.num_res != 1) return false;
 
-    const LewisStructure *ls = &mol.res[0];
+    const LewisStructure *ls = form_of(&mol, 0);
     if (ls->num_bonds != 1) return false;
     if (ls->bonds[0].order != 1) return false;
     if (ls->lone_pairs[0] != 0 || ls->lone_pairs[1] != 0) return false;
@@ -290,7 +313,7 @@ static bool test_o2_basic(void)
     if (!success_invariants(&mol)) return false;
     if (mol.num_res != 1) return false;
 
-    const LewisStructure *ls = &mol.res[0];
+    const LewisStructure *ls = form_of(&mol, 0);
     if (ls->num_bonds != 1) return false;
     if (ls->bonds[0].order != 2) return false;
     if (ls->lone_pairs[mol.central] != 2) return false;
@@ -311,7 +334,7 @@ static bool test_n2_basic(void)
     if (!success_invariants(&mol)) return false;
     if (mol.num_res != 1) return false;
 
-    const LewisStructure *ls = &mol.res[0];
+    const LewisStructure *ls = form_of(&mol, 0);
     if (ls->num_bonds != 1) return false;
     if (ls->bonds[0].order != 3) return false;
     if (ls->lone_pairs[mol.central] != 1) return false;
@@ -333,7 +356,7 @@ static bool test_ch4_basic(void)
     if (mol.num_res != 1) return false;
     if (mol.atoms[mol.central].elem != ELEM_C) return false;
 
-    const LewisStructure *ls = &mol.res[0];
+    const LewisStructure *ls = form_of(&mol, 0);
     if (bond_order_sum(ls, mol.central) != 4) return false;
     if (central_bond_count_by_order(&mol, ls, 1) != 4) return false;
     if (ls->lone_pairs[mol.central] != 0) return false;
@@ -355,7 +378,7 @@ static bool test_nh3_basic(void)
     if (mol.num_res != 1) return false;
     if (mol.atoms[mol.central].elem != ELEM_N) return false;
 
-    const LewisStructure *ls = &mol.res[0];
+    const LewisStructure *ls = form_of(&mol, 0);
     if (bond_order_sum(ls, mol.central) != 3) return false;
     if (central_bond_count_by_order(&mol, ls, 1) != 3) return false;
     if (ls->lone_pairs[mol.central] != 1) return false;
@@ -378,14 +401,14 @@ static bool test_no2_minus_resonance(void)
     if (mol.atoms[mol.central].elem != ELEM_N) return false;
 
     for (uint8_t i = 0; i < mol.num_res; i++) {
-        const LewisStructure *ls = &mol.res[i];
+        const LewisStructure *ls = form_of(&mol, i);
         if (bond_order_sum(ls, mol.central) != 3) return false;
         if (central_double_bond_count(&mol, ls) != 1) return false;
         if (central_bond_count_by_order(&mol, ls, 1) != 1) return false;
         if (ls->lone_pairs[mol.central] != 1) return false;
     }
 
-    if (!lewis_get_vsepr_info(&mol, &mol.res[mol.cur_res], &info)) return false;
+    if (!lewis_get_vsepr_info(&mol, form_of(&mol, mol.cur_res), &info)) return false;
     if (!vsepr_info_matches(&info, 3, 2, 1, "Trigonal Planar", "Bent", "sp2")) return false;
     return true;
 }
@@ -402,7 +425,7 @@ static bool test_clo3_minus_oxyanion(void)
     if (mol.atoms[mol.central].elem != ELEM_CL_IDX) return false;
 
     for (uint8_t i = 0; i < mol.num_res; i++) {
-        const LewisStructure *ls = &mol.res[i];
+        const LewisStructure *ls = form_of(&mol, i);
         if (bond_order_sum(ls, mol.central) != 5) return false;
         if (central_double_bond_count(&mol, ls) != 2) return false;
         if (central_bond_count_by_order(&mol, ls, 1) != 1) return false;
@@ -410,7 +433,7 @@ static bool test_clo3_minus_oxyanion(void)
         if (formal_charge_sum(&mol, ls) != -1) return false;
     }
 
-    if (!lewis_get_vsepr_info(&mol, &mol.res[mol.cur_res], &info)) return false;
+    if (!lewis_get_vsepr_info(&mol, form_of(&mol, mol.cur_res), &info)) return false;
     if (!vsepr_info_matches(&info, 4, 3, 1, "Tetrahedral", "Trigonal Pyramidal", "sp3")) return false;
     return true;
 }
@@ -427,7 +450,7 @@ static bool test_clo4_minus_oxyanion(void)
     if (mol.atoms[mol.central].elem != ELEM_CL_IDX) return false;
 
     for (uint8_t i = 0; i < mol.num_res; i++) {
-        const LewisStructure *ls = &mol.res[i];
+        const LewisStructure *ls = form_of(&mol, i);
         if (bond_order_sum(ls, mol.central) != 7) return false;
         if (central_double_bond_count(&mol, ls) != 3) return false;
         if (central_bond_count_by_order(&mol, ls, 1) != 1) return false;
@@ -435,7 +458,7 @@ static bool test_clo4_minus_oxyanion(void)
         if (formal_charge_sum(&mol, ls) != -1) return false;
     }
 
-    if (!lewis_get_vsepr_info(&mol, &mol.res[mol.cur_res], &info)) return false;
+    if (!lewis_get_vsepr_info(&mol, form_of(&mol, mol.cur_res), &info)) return false;
     if (!vsepr_info_matches(&info, 4, 4, 0, "Tetrahedral", "Tetrahedral", "sp3")) return false;
     return true;
 }
@@ -451,7 +474,7 @@ static bool test_xef2_hypervalent(void)
     if (mol.num_res != 1) return false;
     if (mol.atoms[mol.central].elem != ELEM_XE_IDX) return false;
 
-    const LewisStructure *ls = &mol.res[0];
+    const LewisStructure *ls = form_of(&mol, 0);
     if (bond_order_sum(ls, mol.central) != 2) return false;
     if (central_bond_count_by_order(&mol, ls, 1) != 2) return false;
     if (ls->lone_pairs[mol.central] != 3) return false;
@@ -472,7 +495,7 @@ static bool test_xef4_hypervalent(void)
     if (mol.num_res != 1) return false;
     if (mol.atoms[mol.central].elem != ELEM_XE_IDX) return false;
 
-    const LewisStructure *ls = &mol.res[0];
+    const LewisStructure *ls = form_of(&mol, 0);
     if (bond_order_sum(ls, mol.central) != 4) return false;
     if (central_bond_count_by_order(&mol, ls, 1) != 4) return false;
     if (ls->lone_pairs[mol.central] != 2) return false;
@@ -493,7 +516,7 @@ static bool test_if7_vsepr_supported(void)
     if (mol.num_res != 1) return false;
     if (mol.atoms[mol.central].elem != ELEM_I_IDX) return false;
 
-    const LewisStructure *ls = &mol.res[0];
+    const LewisStructure *ls = form_of(&mol, 0);
     if (bond_order_sum(ls, mol.central) != 7) return false;
     if (central_bond_count_by_order(&mol, ls, 1) != 7) return false;
     if (ls->lone_pairs[mol.central] != 0) return false;
@@ -514,7 +537,7 @@ static bool test_cse2_center_and_geometry(void)
     if (mol.num_res != 1) return false;
     if (mol.atoms[mol.central].elem != ELEM_C) return false;
 
-    LewisStructure *ls = &mol.res[0];
+    LewisStructure *ls = form_of(&mol, 0);
     if (bond_order_sum(ls, mol.central) != 4) return false;
     if (central_double_bond_count(&mol, ls) != 2) return false;
     if (ls->lone_pairs[mol.central] != 0) return false;
@@ -536,7 +559,7 @@ static bool test_nitrate(void)
     if (mol.atoms[mol.central].elem != ELEM_N) return false;
 
     for (uint8_t i = 0; i < mol.num_res; i++) {
-        const LewisStructure *ls = &mol.res[i];
+        const LewisStructure *ls = form_of(&mol, i);
         if (bond_order_sum(ls, mol.central) != 4) return false;
         if (central_double_bond_count(&mol, ls) != 1) return false;
     }
@@ -554,7 +577,7 @@ static bool test_sulfate(void)
     if (mol.atoms[mol.central].elem != ELEM_S) return false;
 
     for (uint8_t i = 0; i < mol.num_res; i++) {
-        const LewisStructure *ls = &mol.res[i];
+        const LewisStructure *ls = form_of(&mol, i);
         if (bond_order_sum(ls, mol.central) != 6) return false;
         if (central_double_bond_count(&mol, ls) != 2) return false;
     }
@@ -571,7 +594,7 @@ static bool test_ammonium(void)
     if (mol.num_res != 1) return false;
     if (mol.atoms[mol.central].elem != ELEM_N) return false;
 
-    LewisStructure *ls = &mol.res[0];
+    LewisStructure *ls = form_of(&mol, 0);
     if (bond_order_sum(ls, mol.central) != 4) return false;
     if (ls->lone_pairs[mol.central] != 0) return false;
     if (ls->formal_charge[mol.central] != 1) return false;
@@ -589,7 +612,7 @@ static bool test_carbonate(void)
     if (mol.atoms[mol.central].elem != ELEM_C) return false;
 
     for (uint8_t i = 0; i < mol.num_res; i++) {
-        const LewisStructure *ls = &mol.res[i];
+        const LewisStructure *ls = form_of(&mol, i);
         if (bond_order_sum(ls, mol.central) != 4) return false;
         if (central_double_bond_count(&mol, ls) != 1) return false;
     }
@@ -607,7 +630,7 @@ static bool test_phosphate(void)
     if (mol.atoms[mol.central].elem != ELEM_P_IDX) return false;
 
     for (uint8_t i = 0; i < mol.num_res; i++) {
-        const LewisStructure *ls = &mol.res[i];
+        const LewisStructure *ls = form_of(&mol, i);
         if (bond_order_sum(ls, mol.central) != 5) return false;
         if (central_double_bond_count(&mol, ls) != 1) return false;
     }
@@ -624,7 +647,7 @@ static bool test_bf3_incomplete_octet(void)
     if (mol.num_res != 1) return false;
     if (mol.atoms[mol.central].elem != ELEM_B_IDX) return false;
 
-    LewisStructure *ls = &mol.res[0];
+    LewisStructure *ls = form_of(&mol, 0);
     if (bond_order_sum(ls, mol.central) != 3) return false;
     if (ls->lone_pairs[mol.central] != 0) return false;
     return true;
@@ -639,7 +662,7 @@ static bool test_sf6_expanded_valence(void)
     if (!success_invariants(&mol)) return false;
     if (mol.num_res != 1) return false;
     if (mol.atoms[mol.central].elem != ELEM_S) return false;
-    if (bond_order_sum(&mol.res[0], mol.central) != 6) return false;
+    if (bond_order_sum(form_of(&mol, 0), mol.central) != 6) return false;
     return true;
 }
 
@@ -652,7 +675,7 @@ static bool test_pcl5_expanded_valence(void)
     if (!success_invariants(&mol)) return false;
     if (mol.num_res != 1) return false;
     if (mol.atoms[mol.central].elem != ELEM_P_IDX) return false;
-    if (bond_order_sum(&mol.res[0], mol.central) != 5) return false;
+    if (bond_order_sum(form_of(&mol, 0), mol.central) != 5) return false;
     return true;
 }
 
@@ -667,7 +690,7 @@ static bool test_icl5_expanded_valence(void)
     if (mol.num_res != 1) return false;
     if (mol.atoms[mol.central].elem != ELEM_I_IDX) return false;
 
-    LewisStructure *ls = &mol.res[0];
+    LewisStructure *ls = form_of(&mol, 0);
     if (bond_order_sum(ls, mol.central) != 5) return false;
     if (ls->lone_pairs[mol.central] != 1) return false;
 
@@ -685,6 +708,891 @@ static bool test_icl5_expanded_valence(void)
     return true;
 }
 
+static bool layout_atoms_distinct(const Molecule *mol, const AtomLayout *lay)
+{
+    for (uint8_t i = 0; i < mol->num_atoms; i++) {
+        for (uint8_t j = i + 1; j < mol->num_atoms; j++) {
+            if (lay->x[i] == lay->x[j] && lay->y[i] == lay->y[j]) return false;
+        }
+    }
+    return true;
+}
+
+static bool test_layout_co2_linear(void)
+{
+    Molecule mol;
+    const uint8_t atoms[] = { ELEM_C, ELEM_O, ELEM_O };
+    build_and_generate(&mol, 0, atoms, (uint8_t)(sizeof(atoms) / sizeof(atoms[0])));
+
+    if (!success_invariants(&mol)) return false;
+    const AtomLayout *lay = &mol.layout[0];
+    if (lay->x[mol.central] != LEWIS_CENTER_X || lay->y[mol.central] != LEWIS_CENTER_Y) return false;
+    for (uint8_t i = 0; i < mol.num_atoms; i++) {
+        if (lay->y[i] != LEWIS_CENTER_Y) return false;
+    }
+    return layout_atoms_distinct(&mol, lay);
+}
+
+static bool test_layout_vsepr_projection(void)
+{
+    Molecule mol;
+    const uint8_t water[] = { ELEM_O, ELEM_H, ELEM_H };
+    build_and_generate(&mol, 0, water, (uint8_t)(sizeof(water) / sizeof(water[0])));
+    if (!success_invariants(&mol)) return false;
+
+    /* Bent: both hydrogens below the oxygen, mirrored, pairs above first. */
+    const AtomLayout *lay = &mol.layout[0];
+    uint8_t h1 = (mol.central == 0) ? 1 : 0;
+    uint8_t h2 = (mol.central == 2) ? 1 : 2;
+    int cx = lay->x[mol.central];
+    int cy = lay->y[mol.central];
+    if (lay->y[h1] <= cy || lay->y[h1] != lay->y[h2]) return false;
+    if (lay->x[h1] - cx != cx - lay->x[h2]) return false;
+    if (layout_lone_pair_slot(lay, mol.central, 0) != LP_SLOT_UP) return false;
+
+    /* Seesaw: axial bonds up and down, the lone pair on the open side. */
+    const uint8_t sf4[] = { ELEM_S, ELEM_F_IDX, ELEM_F_IDX, ELEM_F_IDX, ELEM_F_IDX };
+    build_and_generate(&mol, 0, sf4, (uint8_t)(sizeof(sf4) / sizeof(sf4[0])));
+    if (!success_invariants(&mol)) return false;
+    if (form_of(&mol, 0)->lone_pairs[mol.central] != 1) return false;
+
+    lay = &mol.layout[0];
+    int left_of_center = 0;
+    for (uint8_t i = 0; i < mol.num_atoms; i++) {
+        if (lay->x[i] < lay->x[mol.central]) left_of_center++;
+    }
+    return left_of_center == 0 &&
+           layout_lone_pair_slot(lay, mol.central, 0) == LP_SLOT_LEFT &&
+           layout_atoms_distinct(&mol, lay);
+}
+
+static bool test_layout_benzene_ring(void)
+{
+    Molecule mol;
+    LewisStructure ls;
+    AtomLayout lay;
+    molecule_reset(&mol);
+    memset(&ls, 0, sizeof(ls));
+
+    /* C6H6 skeleton: carbons 0-5 in a ring, hydrogen 6+k on carbon k. */
+    mol.num_atoms = 12;
+    for (uint8_t k = 0; k < 6; k++) {
+        mol.atoms[k].elem = ELEM_C;
+        mol.atoms[k + 6].elem = ELEM_H;
+        ls.bonds[ls.num_bonds++] = (Bond){ k, (uint8_t)((k + 1) % 6), (uint8_t)(1 + (k & 1)) };
+        ls.bonds[ls.num_bonds++] = (Bond){ k, (uint8_t)(k + 6), 1 };
+    }
+
+    LayoutRing rings[LAYOUT_MAX_RINGS];
+    if (layout_find_rings(&mol, &ls, rings, LAYOUT_MAX_RINGS) != 1) return false;
+    if (rings[0].len != 6 || rings[0].mask != 0x3F) return false;
+
+    layout_structure(&mol, &ls, &lay, lewis_scratch());
+
+    int cx = 0;
+    int cy = 0;
+    for (uint8_t k = 0; k < 6; k++) {
+        cx += lay.x[k];
+        cy += lay.y[k];
+    }
+    cx /= 6;
+    cy /= 6;
+
+    for (uint8_t b = 0; b < ls.num_bonds; b++) {
+        int dx = lay.x[ls.bonds[b].a] - lay.x[ls.bonds[b].b];
+        int dy = lay.y[ls.bonds[b].a] - lay.y[ls.bonds[b].b];
+        int d2 = dx * dx + dy * dy;
+        if (d2 < (BOND_LEN - 2) * (BOND_LEN - 2) || d2 > (BOND_LEN + 2) * (BOND_LEN + 2)) return false;
+    }
+
+    /* Every hydrogen points away from the ring centre. */
+    for (uint8_t k = 0; k < 6; k++) {
+        int cdx = lay.x[k] - cx;
+        int cdy = lay.y[k] - cy;
+        int hdx = lay.x[k + 6] - cx;
+        int hdy = lay.y[k + 6] - cy;
+        if (hdx * hdx + hdy * hdy <= cdx * cdx + cdy * cdy) return false;
+        if (lay.y[k + 6] < 0 || lay.y[k + 6] >= SCR_H || lay.x[k + 6] < 0 || lay.x[k + 6] >= SCR_W) return false;
+    }
+    return layout_atoms_distinct(&mol, &lay);
+}
+
+static bool test_layout_ring_vertex_fan(void)
+{
+    Molecule mol;
+    LewisStructure ls;
+    AtomLayout lay;
+    molecule_reset(&mol);
+    memset(&ls, 0, sizeof(ls));
+
+    /* Three-membered S-C-C ring with four fluorines on the sulfur. */
+    mol.num_atoms = 7;
+    mol.atoms[0].elem = ELEM_S;
+    mol.atoms[1].elem = ELEM_C;
+    mol.atoms[2].elem = ELEM_C;
+    for (uint8_t k = 0; k < 3; k++) {
+        ls.bonds[ls.num_bonds++] = (Bond){ k, (uint8_t)((k + 1) % 3), 1 };
+    }
+    for (uint8_t f = 3; f < 7; f++) {
+        mol.atoms[f].elem = ELEM_F_IDX;
+        ls.bonds[ls.num_bonds++] = (Bond){ 0, f, 1 };
+    }
+
+    if (!layout_rings(&mol, &ls, &lay, lewis_scratch())) return false;
+
+    /* Nothing crowds: a fourth fluorine must not reuse the first one's turn. */
+    for (uint8_t i = 0; i < 7; i++) {
+        for (uint8_t j = (uint8_t)(i + 1); j < 7; j++) {
+            int dx = lay.x[i] - lay.x[j];
+            int dy = lay.y[i] - lay.y[j];
+            if (dx * dx + dy * dy < (BOND_LEN / 2) * (BOND_LEN / 2)) return false;
+        }
+    }
+    return layout_atoms_distinct(&mol, &lay);
+}
+
+static bool test_layout_stress_propane(void)
+{
+    Molecule mol;
+    const uint8_t atoms[] = {
+        ELEM_C, ELEM_C, ELEM_C, ELEM_H, ELEM_H, ELEM_H, ELEM_H, ELEM_H, ELEM_H, ELEM_H, ELEM_H
+    };
+    build_and_generate(&mol, 0, atoms, (uint8_t)(sizeof(atoms) / sizeof(atoms[0])));
+
+    if (!success_invariants(&mol)) return false;
+    const LewisStructure *ls = form_of(&mol, 0);
+    const AtomLayout *lay = &mol.layout[0];
+
+    /* Bonds stay near BOND_LEN. */
+    for (uint8_t b = 0; b < ls->num_bonds; b++) {
+        int dx = lay->x[ls->bonds[b].a] - lay->x[ls->bonds[b].b];
+        int dy = lay->y[ls->bonds[b].a] - lay->y[ls->bonds[b].b];
+        int d2 = dx * dx + dy * dy;
+        if (d2 < (BOND_LEN - 5) * (BOND_LEN - 5) || d2 > (BOND_LEN + 8) * (BOND_LEN + 8)) return false;
+    }
+
+    /* No two atoms crowd each other, and everything is on screen. */
+    for (uint8_t i = 0; i < mol.num_atoms; i++) {
+        if (lay->x[i] < 0 || lay->x[i] >= SCR_W || lay->y[i] < 0 || lay->y[i] >= SCR_H) return false;
+        for (uint8_t j = i + 1; j < mol.num_atoms; j++) {
+            int dx = lay->x[i] - lay->x[j];
+            int dy = lay->y[i] - lay->y[j];
+            if (dx * dx + dy * dy < 40 * 40) return false;
+        }
+    }
+
+    /* A converged layout is a fixed point: rerunning it moves nothing much. */
+    AtomLayout again = *lay;
+    return layout_stress(&mol, ls, &again, LAYOUT_STRESS_SWEEPS, lewis_scratch()) < LAYOUT_STRESS_SWEEPS;
+}
+
+static bool test_layout_per_resonance_form(void)
+{
+    Molecule mol;
+    const uint8_t atoms[] = { ELEM_C, ELEM_O, ELEM_O, ELEM_O };
+    build_and_generate(&mol, -2, atoms, (uint8_t)(sizeof(atoms) / sizeof(atoms[0])));
+
+    if (!success_invariants(&mol)) return false;
+    if (mol.num_res != 3) return false;
+
+    for (uint8_t r = 0; r < mol.num_res; r++) {
+        AtomLayout expect;
+        layout_structure(&mol, form_of(&mol, r), &expect, lewis_scratch());
+        if (memcmp(&expect, &mol.layout[r], sizeof(expect)) != 0) return false;
+        if (mol.layout[r].x[mol.central] != LEWIS_CENTER_X) return false;
+        if (mol.layout[r].y[mol.central] != LEWIS_CENTER_Y) return false;
+        if (!layout_atoms_distinct(&mol, &mol.layout[r])) return false;
+    }
+    return true;
+}
+
+static bool test_lone_pair_slots_avoid_bonds(void)
+{
+    Molecule mol;
+    const uint8_t atoms[] = { ELEM_O, ELEM_H, ELEM_H };
+    build_and_generate(&mol, 0, atoms, (uint8_t)(sizeof(atoms) / sizeof(atoms[0])));
+
+    if (!success_invariants(&mol)) return false;
+    const LewisStructure *ls = form_of(&mol, 0);
+    const AtomLayout *lay = &mol.layout[0];
+    if (ls->lone_pairs[mol.central] != 2) return false;
+
+    for (uint8_t lp = 0; lp < ls->lone_pairs[mol.central]; lp++) {
+        int dots[4];
+        layout_lone_pair_dots(lay, mol.central, lp, dots);
+        int mx = (dots[0] + dots[2]) / 2;
+        int my = (dots[1] + dots[3]) / 2;
+
+        /* A pair must not sit on the segment toward any bonded hydrogen. */
+        for (uint8_t b = 0; b < ls->num_bonds; b++) {
+            uint8_t other = (ls->bonds[b].a == mol.central) ? ls->bonds[b].b : ls->bonds[b].a;
+            int bx = lay->x[other] - lay->x[mol.central];
+            int by = lay->y[other] - lay->y[mol.central];
+            int px = mx - lay->x[mol.central];
+            int py = my - lay->y[mol.central];
+            if (px * bx + py * by > 0 && px * by - py * bx == 0) return false;
+        }
+    }
+
+    /* The two pairs use different slots. */
+    return layout_lone_pair_slot(lay, mol.central, 0) != layout_lone_pair_slot(lay, mol.central, 1);
+}
+
+static bool test_display_list_sulfate(void)
+{
+    Molecule mol;
+    const uint8_t atoms[] = { ELEM_S, ELEM_O, ELEM_O, ELEM_O, ELEM_O };
+    build_and_generate(&mol, -2, atoms, (uint8_t)(sizeof(atoms) / sizeof(atoms[0])));
+
+    if (!success_invariants(&mol)) return false;
+    const LewisStructure *ls = form_of(&mol, 0);
+
+    DisplayList dl;
+    display_list_build(&mol, ls, &mol.layout[0], &dl);
+
+    uint8_t counts[DL_CARD + 1] = { 0 };
+    int lone_pairs = 0;
+    int charged = 0;
+    for (uint8_t i = 0; i < mol.num_atoms; i++) {
+        lone_pairs += ls->lone_pairs[i];
+        if (ls->formal_charge[i] != 0) charged++;
+    }
+
+    for (uint8_t i = 0; i < dl.count; i++) {
+        const DlPrim *p = &dl.prims[i];
+        if (p->box.w <= 0 || p->box.h <= 0) return false;
+        counts[p->kind]++;
+
+        if (p->kind == DL_CHARGE && p->text[0] != (ls->formal_charge[p->atom] > 0 ? '+' : '-')) return false;
+        if (p->kind == DL_BOND && (p->flags & DL_FLAG_CENTRAL) == 0) return false;
+    }
+
+    if (counts[DL_BOND] != ls->num_bonds) return false;
+    if (counts[DL_SYMBOL] != mol.num_atoms) return false;
+    if (counts[DL_DOTS] != lone_pairs) return false;
+    if (counts[DL_CHARGE] != charged) return false;
+    if (counts[DL_CARD] != 0) return false;
+
+    DlBox card = { 0, 0, 10, 10 };
+    if (!display_list_add_card(&dl, &card)) return false;
+    return dl.prims[dl.count - 1].kind == DL_CARD;
+}
+
+static bool test_occupancy_counts_match_scan(void)
+{
+    static OccupancyGrid g;
+    const DlBox marks[] = {
+        { 10, 10, 5, 5 }, { 150, 100, 30, 12 }, { -20, 230, 40, 30 }, { 316, 0, 20, 20 }, { 60, 60, 0, 9 }
+    };
+    const DlBox queries[] = {
+        { 0, 0, SCR_W, SCR_H }, { 8, 8, 8, 8 }, { 196, 28, 120, 126 }, { 140, 96, 16, 16 }, { -50, -50, 70, 70 }
+    };
+
+    occupancy_clear(&g);
+    for (uint8_t i = 0; i < sizeof(marks) / sizeof(marks[0]); i++) {
+        occupancy_mark(&g, &marks[i]);
+    }
+    occupancy_finish(&g);
+
+    for (uint8_t q = 0; q < sizeof(queries) / sizeof(queries[0]); q++) {
+        const DlBox *b = &queries[q];
+        uint16_t expect = 0;
+        for (int r = 0; r < OCC_ROWS; r++) {
+            for (int c = 0; c < OCC_COLS; c++) {
+                int cx = c * OCC_CELL;
+                int cy = r * OCC_CELL;
+                if (cx + OCC_CELL <= b->x || cx >= b->x + b->w) continue;
+                if (cy + OCC_CELL <= b->y || cy >= b->y + b->h) continue;
+                if ((g.bits[r][c >> 3] >> (c & 7)) & 1u) expect++;
+            }
+        }
+        if (occupancy_count(&g, b) != expect) return false;
+    }
+
+    /* 5x5 at (10,10) stays in cell (1,1); the zero-width box marks nothing. */
+    DlBox one = { 8, 8, 8, 8 };
+    DlBox empty = { 56, 56, 16, 16 };
+    return occupancy_count(&g, &one) == 1 && occupancy_count(&g, &empty) == 0;
+}
+
+static bool packed_matches(const Molecule *a, const Molecule *b)
+{
+    if (a->num_atoms != b->num_atoms || a->charge != b->charge) return false;
+    if (a->central != b->central || a->num_res != b->num_res) return false;
+    if (a->total_ve != b->total_ve || a->invalid_reason != b->invalid_reason) return false;
+    for (uint8_t i = 0; i < a->num_atoms; i++) {
+        if (a->atoms[i].elem != b->atoms[i].elem) return false;
+    }
+    for (uint8_t r = 0; r < a->num_res; r++) {
+        if (!structures_equal(a, form_of(a, r), form_of(b, r))) return false;
+        if (memcmp(form_of(a, r)->formal_charge, form_of(b, r)->formal_charge, a->num_atoms) != 0) return false;
+        if (memcmp(&a->layout[r], &b->layout[r], sizeof(AtomLayout)) != 0) return false;
+    }
+    return true;
+}
+
+static bool test_packed_structure(void)
+{
+    /* Every field at its widest: 12 atoms, 12 bonds, indices up to 11, lone pairs up to 7. */
+    Molecule mol;
+    LewisStructure ls;
+    molecule_reset(&mol);
+    memset(&ls, 0, sizeof(ls));
+    mol.num_atoms = MAX_ATOMS;
+    for (uint8_t i = 0; i < MAX_ATOMS; i++) {
+        mol.atoms[i].elem = (i & 1u) ? ELEM_O : ELEM_S;
+        ls.lone_pairs[i] = (uint8_t)((i * 5u + 3u) & 7u);
+    }
+    ls.num_bonds = MAX_BONDS;
+    for (uint8_t k = 0; k < MAX_BONDS; k++) {
+        ls.bonds[k].a = k;
+        ls.bonds[k].b = (uint8_t)((k + 5u) % MAX_ATOMS);
+        ls.bonds[k].order = (uint8_t)(1u + k % 3u);
+    }
+    lewis_recompute_formal_charges(&mol, &ls);
+
+    packed_store(&mol.base, &ls, mol.num_atoms);
+    mol.num_res = 1;
+    if (sizeof(PackedStructure) * 2 >= sizeof(LewisStructure)) return false;
+    for (uint8_t k = 0; k < MAX_BONDS; k++) {
+        Bond b = packed_bond(&mol.base, k);
+        if (b.a != ls.bonds[k].a || b.b != ls.bonds[k].b || b.order != ls.bonds[k].order) return false;
+    }
+    for (uint8_t i = 0; i < MAX_ATOMS; i++) {
+        if (packed_lone_pairs(&mol.base, i) != ls.lone_pairs[i]) return false;
+        if (packed_formal_charge(&mol, &mol.base, i) != ls.formal_charge[i]) return false;
+    }
+    const LewisStructure *back = form_of(&mol, 0);
+    if (!structures_equal(&mol, &ls, back)) return false;
+    if (memcmp(back->formal_charge, ls.formal_charge, MAX_ATOMS) != 0) return false;
+
+    /* Solved forms keep their formal charges through the packed store. */
+    const uint8_t sulfate[] = { ELEM_S, ELEM_O, ELEM_O, ELEM_O, ELEM_O };
+    build_and_generate(&mol, -2, sulfate, (uint8_t)(sizeof(sulfate) / sizeof(sulfate[0])));
+    if (!success_invariants(&mol)) return false;
+    for (uint8_t r = 0; r < mol.num_res; r++) {
+        LewisStructure recomputed = *form_of(&mol, r);
+        lewis_recompute_formal_charges(&mol, &recomputed);
+        if (memcmp(recomputed.formal_charge, form_of(&mol, r)->formal_charge, mol.num_atoms) != 0) return false;
+    }
+    return true;
+}
+
+static bool test_resonance_delta(void)
+{
+    Molecule mol;
+    const uint8_t carbonate[] = { ELEM_C, ELEM_O, ELEM_O, ELEM_O };
+    build_and_generate(&mol, -2, carbonate, (uint8_t)(sizeof(carbonate) / sizeof(carbonate[0])));
+    if (!success_invariants(&mol) || mol.num_res != 3) return false;
+
+    /* Moving the double bond changes two orders and two lone-pair counts. */
+    for (uint8_t r = 1; r < mol.num_res; r++) {
+        if (mol.delta[r - 1].count == 0 || mol.delta[r - 1].count > 4) return false;
+    }
+
+    /* Rebuilding a delta from the unpacked form gives the stored one. */
+    for (uint8_t r = 1; r < mol.num_res; r++) {
+        ResonanceDelta d;
+        if (!resonance_delta(&mol, form_of(&mol, r), &d)) return false;
+        if (d.count != mol.delta[r - 1].count) return false;
+        if (memcmp(d.change, mol.delta[r - 1].change, d.count) != 0) return false;
+    }
+
+    /* Switch one copy through every ordered pair; charges must match a recompute. */
+    LewisStructure cur;
+    uint8_t shown = 0;
+    molecule_form(&mol, 0, &cur);
+    for (uint8_t a = 0; a < mol.num_res; a++) {
+        for (uint8_t b = 0; b < mol.num_res; b++) {
+            uint8_t order[2] = { a, b };
+            for (uint8_t k = 0; k < 2; k++) {
+                resonance_revert(&mol, shown, &cur);
+                resonance_apply(&mol, order[k], &cur);
+                shown = order[k];
+
+                LewisStructure recomputed = cur;
+                lewis_recompute_formal_charges(&mol, &recomputed);
+                if (!structures_equal(&mol, &cur, form_of(&mol, shown))) return false;
+                if (memcmp(cur.formal_charge, recomputed.formal_charge, mol.num_atoms) != 0) return false;
+            }
+        }
+    }
+
+    /* A form on another skeleton has no delta. */
+    LewisStructure other = *form_of(&mol, 0);
+    other.bonds[0].b = other.bonds[1].b;
+    ResonanceDelta d;
+    if (resonance_delta(&mol, &other, &d)) return false;
+
+    /* Deltas are smaller than the full forms they replace. */
+    return sizeof(ResonanceDelta) * 2 < sizeof(LewisStructure);
+}
+
+static bool test_resonance_delta_limit(void)
+{
+    Molecule mol;
+    LewisStructure ls;
+    LewisStructure all;
+    molecule_reset(&mol);
+    memset(&ls, 0, sizeof(ls));
+
+    /* Twelve atoms and twelve bonds, well past MAX_HEAVY heavy atoms. */
+    mol.num_atoms = MAX_ATOMS;
+    for (uint8_t i = 0; i < MAX_ATOMS; i++) {
+        mol.atoms[i].elem = (i == 0) ? ELEM_S : ELEM_O;
+        ls.lone_pairs[i] = 3;
+    }
+    ls.num_bonds = MAX_BONDS;
+    for (uint8_t k = 0; k < MAX_BONDS; k++) {
+        ls.bonds[k].a = (k < MAX_ATOMS - 1) ? 0 : 1;
+        ls.bonds[k].b = (k < MAX_ATOMS - 1) ? (uint8_t)(k + 1) : 2;
+        ls.bonds[k].order = 1;
+    }
+    lewis_recompute_formal_charges(&mol, &ls);
+    packed_store(&mol.base, &ls, mol.num_atoms);
+    mol.num_res = 1;
+
+    /* A form that changes every bond order and every lone-pair count still has a delta. */
+    all = ls;
+    for (uint8_t k = 0; k < MAX_BONDS; k++) all.bonds[k].order = 2;
+    for (uint8_t i = 0; i < MAX_ATOMS; i++) all.lone_pairs[i] = 1;
+    lewis_recompute_formal_charges(&mol, &all);
+
+    ResonanceDelta d;
+    if (!resonance_delta(&mol, &all, &d) || d.count != RES_DELTA_MAX) return false;
+    mol.delta[0] = d;
+    mol.num_res = 2;
+
+    LewisStructure cur = ls;
+    resonance_apply(&mol, 1, &cur);
+    if (!structures_equal(&mol, &cur, &all)) return false;
+    if (memcmp(cur.formal_charge, all.formal_charge, MAX_ATOMS) != 0) return false;
+    resonance_revert(&mol, 1, &cur);
+    return structures_equal(&mol, &cur, &ls) &&
+           memcmp(cur.formal_charge, ls.formal_charge, MAX_ATOMS) == 0;
+}
+
+static bool test_pack_round_trip(void)
+{
+    Molecule src[4];
+    Molecule back;
+    const uint8_t sulfate[] = { ELEM_S, ELEM_O, ELEM_O, ELEM_O, ELEM_O };
+    const uint8_t carbonate[] = { ELEM_C, ELEM_O, ELEM_O, ELEM_O };
+    const uint8_t water[] = { ELEM_O, ELEM_H, ELEM_H };
+    const uint8_t nitric_oxide[] = { ELEM_N, ELEM_O };
+    build_and_generate(&src[0], -2, sulfate, (uint8_t)(sizeof(sulfate) / sizeof(sulfate[0])));
+    build_and_generate(&src[1], -2, carbonate, (uint8_t)(sizeof(carbonate) / sizeof(carbonate[0])));
+    build_and_generate(&src[2], 0, water, (uint8_t)(sizeof(water) / sizeof(water[0])));
+    build_and_generate(&src[3], 0, nitric_oxide, (uint8_t)(sizeof(nitric_oxide) / sizeof(nitric_oxide[0])));
+
+    uint8_t buf[4 * LEWIS_PACK_MAX_BYTES];
+    size_t water_bytes = lewis_pack(&src[2], buf, sizeof(buf));
+    size_t carbonate_bytes = lewis_pack(&src[1], buf, sizeof(buf));
+    if (water_bytes == 0 || water_bytes > 10) return false;
+    if (carbonate_bytes == 0 || carbonate_bytes > 20) return false;
+
+    /* Records stream back to back and decode to the engine's own result. */
+    LewisBitWriter w;
+    lewis_bits_writer_init(&w, buf, sizeof(buf));
+    for (uint8_t i = 0; i < 4; i++) {
+        if (!lewis_pack_write(&w, &src[i])) return false;
+    }
+
+    LewisBitReader r;
+    lewis_bits_reader_init(&r, buf, w.bitpos >> 3);
+    for (uint8_t i = 0; i < 4; i++) {
+        if (!lewis_pack_read(&r, &back)) return false;
+        if (!packed_matches(&src[i], &back)) return false;
+    }
+    if (r.bitpos != w.bitpos) return false;
+
+    /* A buffer too small fails cleanly, and truncated input is rejected. */
+    lewis_bits_writer_init(&w, buf, carbonate_bytes - 1);
+    if (lewis_pack_write(&w, &src[1]) || w.bitpos != 0) return false;
+    lewis_pack(&src[1], buf, sizeof(buf));
+    if (lewis_unpack(&back, buf, carbonate_bytes - 1) != 0) return false;
+    return lewis_unpack(&back, buf, carbonate_bytes) == carbonate_bytes;
+}
+
+static bool test_pack_key_canonical(void)
+{
+    Molecule a;
+    Molecule b;
+    const uint8_t forward[] = { ELEM_S, ELEM_O, ELEM_O, ELEM_O, ELEM_O };
+    const uint8_t shuffled[] = { ELEM_O, ELEM_O, ELEM_S, ELEM_O, ELEM_O };
+    build_molecule(&a, -2, forward, (uint8_t)(sizeof(forward) / sizeof(forward[0])));
+    build_molecule(&b, -2, shuffled, (uint8_t)(sizeof(shuffled) / sizeof(shuffled[0])));
+
+    uint8_t ka[LEWIS_PACK_KEY_BYTES];
+    uint8_t kb[LEWIS_PACK_KEY_BYTES];
+    lewis_pack_key(&a, ka);
+    lewis_pack_key(&b, kb);
+    if (memcmp(ka, kb, sizeof(ka)) != 0) return false;
+    if (ka[0] != 5 || ka[1] != ELEM_O || ka[5] != ELEM_S || (int8_t)ka[6] != -2) return false;
+
+    b.charge = 0;
+    lewis_pack_key(&b, kb);
+    return memcmp(ka, kb, sizeof(ka)) != 0;
+}
+
+static bool test_sdf_carbonate(void)
+{
+    Molecule mol;
+    const uint8_t atoms[] = { ELEM_C, ELEM_O, ELEM_O, ELEM_O };
+    build_and_generate(&mol, -2, atoms, (uint8_t)(sizeof(atoms) / sizeof(atoms[0])));
+    if (mol.num_res != 3) return false;
+
+    static char buf[4096];
+    OutSink out;
+    out_sink_init_buffer(&out, buf, sizeof(buf) - 1);
+    if (!sdf_write_molecule(&out, &mol)) return false;
+    buf[out.len] = '\0';
+
+    /* Three records, each with the counts line, both charges and a terminator. */
+    uint8_t records = 0;
+    for (const char *p = buf; (p = strstr(p, "$$$$\n")) != NULL; p += 5) records++;
+    if (records != 3) return false;
+    if (strncmp(buf, "CO3 -2\n", 7) != 0) return false;
+    if (strstr(buf, "\n  4  3  0  0  0  0  0  0  0  0999 V2000\n") == NULL) return false;
+    if (strstr(buf, "\n    0.0000    0.0000    0.0000 C   0  0") == NULL) return false;
+    if (strstr(buf, "\nM  CHG  2   3  -1   4  -1\n") == NULL) return false;
+    if (strstr(buf, "\n  1  2  2  0\n") == NULL) return false;
+
+    /* A buffer that cannot hold the second record keeps only the first. */
+    size_t first = (size_t)(strstr(buf, "$$$$\n") - buf) + 5;
+    out_sink_init_buffer(&out, buf, first + 10);
+    if (sdf_write_molecule(&out, &mol)) return false;
+    return out.failed && out.len == first;
+}
+
+static uint8_t count_substr(const char *text, const char *needle)
+{
+    uint8_t n = 0;
+    size_t len = strlen(needle);
+    for (const char *p = text; (p = strstr(p, needle)) != NULL; p += len) n++;
+    return n;
+}
+
+static bool test_jsonl_lines(void)
+{
+    Molecule mol;
+    const uint8_t carbonate[] = { ELEM_C, ELEM_O, ELEM_O, ELEM_O };
+    const uint8_t nitric_oxide[] = { ELEM_N, ELEM_O };
+
+    static char buf[4096];
+    OutSink out;
+    out_sink_init_buffer(&out, buf, sizeof(buf) - 1);
+
+    build_and_generate(&mol, -2, carbonate, 4);
+    if (mol.num_res != 3 || !jsonl_write_molecule(&out, &mol)) return false;
+    size_t first = out.len;
+    build_and_generate(&mol, 0, nitric_oxide, 2);
+    if (mol.num_res != 0 || !jsonl_write_molecule(&out, &mol)) return false;
+    buf[out.len] = '\0';
+
+    /* One object per line, each ending in a newline. */
+    if (count_substr(buf, "\n") != 2 || buf[first - 1] != '\n' || buf[0] != '{') return false;
+    const char *head = "{\"formula\":\"CO3\",\"charge\":-2,\"total_ve\":24,\"central\":0,"
+                       "\"atoms\":[\"C\",\"O\",\"O\",\"O\"],\"forms\":[{\"bonds\":[";
+    if (strncmp(buf, head, strlen(head)) != 0) return false;
+    if (count_substr(buf, "\"lone_pairs\":[") != 3) return false;
+    if (strstr(buf, "\"formal_charges\":[0,0,-1,-1]}") == NULL) return false;
+    if (strstr(buf, "\"vsepr\":{\"electron_pairs\":3,\"bond_pairs\":3,\"lone_pairs\":0,"
+                    "\"electron_geometry\":\"Trigonal Planar\",\"shape\":\"Trigonal Planar\","
+                    "\"hybridization\":\"sp2\",\"bond_angle\":\"120\"},\"invalid_reason\":null}\n") == NULL) return false;
+    if (strcmp(buf + first, "{\"formula\":\"NO\",\"charge\":0,\"total_ve\":11,\"central\":null,"
+                            "\"atoms\":[\"N\",\"O\"],\"forms\":[],\"vsepr\":null,"
+                            "\"invalid_reason\":\"Odd electron count (radicals unsupported)\"}\n") != 0) return false;
+
+    /* A line that does not fit is dropped whole. */
+    out_sink_init_buffer(&out, buf, first + 20);
+    build_and_generate(&mol, -2, carbonate, 4);
+    if (!jsonl_write_molecule(&out, &mol) || jsonl_write_molecule(&out, &mol)) return false;
+    return out.failed && out.len == first;
+}
+
+static bool test_svg_carbonate(void)
+{
+    Molecule mol;
+    const uint8_t atoms[] = { ELEM_C, ELEM_O, ELEM_O, ELEM_O };
+    build_and_generate(&mol, -2, atoms, (uint8_t)(sizeof(atoms) / sizeof(atoms[0])));
+    if (mol.num_res != 3) return false;
+
+    static DisplayList dl;
+    display_list_build(&mol, form_of(&mol, 0), &mol.layout[0], &dl);
+    uint8_t symbols = 0;
+    uint8_t dots = 0;
+    uint8_t charges = 0;
+    for (uint8_t i = 0; i < dl.count; i++) {
+        if (dl.prims[i].kind == DL_SYMBOL) symbols++;
+        else if (dl.prims[i].kind == DL_DOTS) dots++;
+        else if (dl.prims[i].kind == DL_CHARGE) charges++;
+    }
+
+    static char buf[8192];
+    OutSink out;
+    out_sink_init_buffer(&out, buf, sizeof(buf) - 1);
+    if (!svg_write_form(&out, &mol, 0, SVG_VSEPR_PANEL)) return false;
+    buf[out.len] = '\0';
+
+    /* One element per display primitive: a path for all bonds, two circles per pair. */
+    if (strncmp(buf, "<svg xmlns=", 11) != 0 || strstr(buf, "</svg>\n") != buf + out.len - 7) return false;
+    if (count_substr(buf, "<path") != 1 || count_substr(buf, "<circle") != dots * 2) return false;
+    if (count_substr(buf, ">C</text>") != 1 || count_substr(buf, ">O</text>") != 3) return false;
+    if (charges != 2 || count_substr(buf, ">-1</text>") != charges) return false;
+    if (symbols != 4) return false;
+    if (strstr(buf, ">VSEPR</text>") == NULL || strstr(buf, ">EP:3 BP:3 LP:0</text>") == NULL) return false;
+
+    /* A sink that cannot hold the document keeps nothing of it. */
+    out_sink_init_buffer(&out, buf, 64);
+    if (svg_write_form(&out, &mol, 0, 0)) return false;
+    return out.failed && out.len == 0;
+}
+
+/* File-backed ResultCacheStore standing in for the AppVar; ctx is the path. */
+static bool file_cache_load(void *ctx, uint8_t *buf, size_t cap, size_t *len)
+{
+    FILE *f = fopen((const char *)ctx, "rb");
+    if (f == NULL) return false;
+    *len = fread(buf, 1, cap, f);
+    fclose(f);
+    return true;
+}
+
+static bool file_cache_save(void *ctx, const uint8_t *buf, size_t len)
+{
+    FILE *f = fopen((const char *)ctx, "wb");
+    if (f == NULL) return false;
+    bool ok = fwrite(buf, 1, len, f) == len;
+    return (fclose(f) == 0) && ok;
+}
+
+static bool test_result_cache(void)
+{
+    const uint8_t water[] = { ELEM_O, ELEM_H, ELEM_H };
+    const uint8_t carbonate[] = { ELEM_C, ELEM_O, ELEM_O, ELEM_O };
+    const uint8_t sulfate[] = { ELEM_S, ELEM_O, ELEM_O, ELEM_O, ELEM_O };
+    const uint8_t ammonia[] = { ELEM_N, ELEM_H, ELEM_H, ELEM_H };
+    Molecule fresh[4];
+    build_and_generate(&fresh[0], 0, water, (uint8_t)(sizeof(water) / sizeof(water[0])));
+    build_and_generate(&fresh[1], -2, carbonate, (uint8_t)(sizeof(carbonate) / sizeof(carbonate[0])));
+    build_and_generate(&fresh[2], -2, sulfate, (uint8_t)(sizeof(sulfate) / sizeof(sulfate[0])));
+    build_and_generate(&fresh[3], 0, ammonia, (uint8_t)(sizeof(ammonia) / sizeof(ammonia[0])));
+
+    static uint8_t buf[RESULT_CACHE_BYTES];
+    ResultCache cache;
+    Molecule mol;
+    result_cache_init(&cache, buf, sizeof(buf));
+
+    /* Misses solve and insert; a hit equals a fresh solve. */
+    for (uint8_t k = 0; k < 3; k++) {
+        mol = fresh[k];
+        mol.num_res = 0;
+        if (result_cache_solve(&cache, &mol) || !packed_matches(&mol, &fresh[k])) return false;
+    }
+    build_molecule(&mol, -2, carbonate, (uint8_t)(sizeof(carbonate) / sizeof(carbonate[0])));
+    if (!result_cache_solve(&cache, &mol) || !packed_matches(&mol, &fresh[1])) return false;
+
+    /* Layouts come back from the entry, not from a relayout: carbonate is now first, its last byte the last lp_slots. */
+    uint8_t *front = buf + RESULT_CACHE_HEADER;
+    uint8_t *last = front + 8 + (front[6] | (front[7] << 8)) - 1;
+    *last ^= 0xFF;
+    build_molecule(&mol, -2, carbonate, 4);
+    if (!result_cache_lookup(&cache, &mol) || mol.layout[mol.num_res - 1].lp_slots[3] != *last) return false;
+    *last ^= 0xFF;
+
+    /* Same atoms in another order, or another charge, are different entries. */
+    const uint8_t water_h_first[] = { ELEM_H, ELEM_O, ELEM_H };
+    build_molecule(&mol, 0, water_h_first, 3);
+    if (result_cache_lookup(&cache, &mol) || mol.num_res != 0) return false;
+    build_molecule(&mol, 1, water, 3);
+    if (result_cache_lookup(&cache, &mol)) return false;
+
+    /* Persist, reload into a fresh cache, and look everything up again. */
+    const char *path = "lewis_cache_test.bin";
+    ResultCacheStore store = { file_cache_load, file_cache_save, (void *)path };
+    if (!cache.dirty || !result_cache_save(&cache, &store) || cache.dirty) return false;
+    size_t saved_len = cache.len;
+    static uint8_t buf2[RESULT_CACHE_BYTES];
+    ResultCache loaded;
+    result_cache_init(&loaded, buf2, sizeof(buf2));
+    if (!result_cache_load(&loaded, &store) || loaded.count != 3 || loaded.len != saved_len) return false;
+    for (uint8_t k = 0; k < 3; k++) {
+        build_molecule(&mol, fresh[k].charge, k == 0 ? water : k == 1 ? carbonate : sulfate, fresh[k].num_atoms);
+        if (!result_cache_lookup(&loaded, &mol) || !packed_matches(&mol, &fresh[k])) return false;
+    }
+
+    /*
+     * LRU order is now sulfate, carbonate, water. Shrink the capacity so
+     * ammonia fits exactly in place of water (entry head: count, atoms,
+     * charge, two length bytes; body: record and one layout per form); a
+     * re-used carbonate survives.
+     */
+    build_molecule(&mol, -2, carbonate, 4);
+    if (!result_cache_lookup(&loaded, &mol)) return false;
+    uint8_t record[LEWIS_PACK_MAX_BYTES];
+    size_t water_entry = 7 + lewis_pack(&fresh[0], record, sizeof(record)) + 3u * RESULT_CACHE_LAYOUT_BYTES;
+    size_t ammonia_entry = 8 + lewis_pack(&fresh[3], record, sizeof(record)) + 4u * RESULT_CACHE_LAYOUT_BYTES;
+    loaded.cap = loaded.len - water_entry + ammonia_entry;
+    mol = fresh[3];
+    result_cache_insert(&loaded, &mol);
+    if (loaded.count != 3 || loaded.len > loaded.cap) return false;
+    build_molecule(&mol, 0, water, 3);
+    if (result_cache_lookup(&loaded, &mol)) return false;
+    build_molecule(&mol, -2, sulfate, 5);
+    if (!result_cache_lookup(&loaded, &mol)) return false;
+    build_molecule(&mol, 0, ammonia, 4);
+    if (!result_cache_lookup(&loaded, &mol) || !packed_matches(&mol, &fresh[3])) return false;
+
+    /* An image whose first body length (carbonate) overruns it is rejected, leaving an empty cache. */
+    buf[RESULT_CACHE_HEADER + 4 + 3] = 0xFF;
+    if (!file_cache_save((void *)path, buf, cache.len)) return false;
+    bool rejected = !result_cache_load(&loaded, &store) && loaded.count == 0 && loaded.len == RESULT_CACHE_HEADER;
+    remove(path);
+    return rejected && !result_cache_load(&loaded, &store);
+}
+
+static bool smiles_solve(const char *text, Molecule *mol)
+{
+    LewisStructure skeleton;
+    if (!smiles_parse(text, mol, &skeleton)) return false;
+    generate_resonance_with_skeleton(mol, &skeleton);
+    return mol->num_res > 0 && success_invariants(mol);
+}
+
+static bool has_bond(const LewisStructure *ls, uint8_t a, uint8_t b, uint8_t order)
+{
+    for (uint8_t k = 0; k < ls->num_bonds; k++) {
+        const Bond *bond = &ls->bonds[k];
+        if (((bond->a == a && bond->b == b) || (bond->a == b && bond->b == a)) && bond->order == order) return true;
+    }
+    return false;
+}
+
+static bool test_smiles_skeleton(void)
+{
+    Molecule mol;
+
+    /* Kekulized benzene, which the skeleton heuristics reject. */
+    if (!smiles_solve("c1ccccc1", &mol)) return false;
+    if (mol.num_atoms != 12 || form_of(&mol, 0)->num_bonds != 12) return false;
+    uint8_t doubles = 0;
+    for (uint8_t b = 0; b < form_of(&mol, 0)->num_bonds; b++) {
+        if (form_of(&mol, 0)->bonds[b].order == 2) doubles++;
+    }
+    if (doubles != 3) return false;
+
+    /* Dimethyl ether keeps C-O-C instead of becoming ethanol. */
+    if (!smiles_solve("COC", &mol)) return false;
+    if (!has_bond(form_of(&mol, 0), 0, 1, 1) || !has_bond(form_of(&mol, 0), 1, 2, 1)) return false;
+    if (form_of(&mol, 0)->lone_pairs[1] != 2) return false;
+
+    /* Acetonitrile: a triple bond on a non-central atom. */
+    if (!smiles_solve("CC#N", &mol)) return false;
+    if (!has_bond(form_of(&mol, 0), 1, 2, 3) || form_of(&mol, 0)->lone_pairs[2] != 1) return false;
+
+    /* Charges from brackets; resonance still runs around the center. */
+    if (!smiles_solve("CC(=O)[O-]", &mol)) return false;
+    if (mol.charge != -1 || mol.central != 1 || mol.num_res != 2) return false;
+    if (!smiles_solve("[O-][N+](=O)[O-]", &mol)) return false;
+    if (mol.charge != -1 || mol.num_res != 3) return false;
+
+    /* Pyrrole needs its [nH]; a bare n has no Kekule form. */
+    LewisStructure skeleton;
+    if (!smiles_parse("c1cc[nH]c1", &mol, &skeleton)) return false;
+    if (smiles_parse("c1ccnc1", &mol, &skeleton)) return false;
+    if (smiles_parse("C(", &mol, &skeleton) || smiles_parse("CC.O", &mol, &skeleton)) return false;
+    if (smiles_parse("CCCCCCCCCCCCC", &mol, &skeleton)) return false;
+
+    /* A skeleton that leaves an atom unbonded is rejected. */
+    if (!smiles_parse("CO", &mol, &skeleton)) return false;
+    skeleton.num_bonds--;
+    generate_resonance_with_skeleton(&mol, &skeleton);
+    return mol.num_res == 0 && mol.invalid_reason == INVALID_SKELETON;
+}
+
+static bool test_resumable_solve_matches(void)
+{
+    Molecule whole;
+    Molecule sliced;
+    const uint8_t atoms[] = { ELEM_S, ELEM_O, ELEM_O, ELEM_O, ELEM_O };
+    build_and_generate(&whole, -2, atoms, (uint8_t)(sizeof(atoms) / sizeof(atoms[0])));
+    build_molecule(&sliced, -2, atoms, (uint8_t)(sizeof(atoms) / sizeof(atoms[0])));
+
+    LewisSolver solver;
+    int steps = 0;
+    uint8_t last_percent = 0;
+    lewis_solve_begin(&solver, &sliced, lewis_scratch());
+    while (lewis_solve_step(&solver, 1) == LEWIS_SOLVE_IN_PROGRESS) {
+        uint8_t percent = lewis_solve_percent(&solver);
+        if (percent < last_percent || percent > 100) return false;
+        last_percent = percent;
+        if (++steps > 1000) return false;
+    }
+
+    if (steps < 2) return false;
+    if (lewis_solve_percent(&solver) != 100) return false;
+    if (!success_invariants(&sliced)) return false;
+    if (sliced.num_res != whole.num_res || sliced.central != whole.central) return false;
+    for (uint8_t r = 0; r < whole.num_res; r++) {
+        if (!structures_equal(&whole, form_of(&whole, r), form_of(&sliced, r))) return false;
+        if (memcmp(&whole.layout[r], &sliced.layout[r], sizeof(AtomLayout)) != 0) return false;
+    }
+    return true;
+}
+
+static bool test_scratch_arena(void)
+{
+    /* Bump, fail without moving, release to a mark, reset keeping the peak. */
+    uint32_t words[16];
+    Arena a;
+    arena_init(&a, words, sizeof(words));
+    uint8_t *p = (uint8_t *)arena_alloc(&a, 5);
+    if (p == NULL || ((uintptr_t)p % ARENA_ALIGN) != 0 || a.used != ARENA_ROUND(5)) return false;
+    size_t mark = arena_mark(&a);
+    if (arena_alloc(&a, 40) == NULL) return false;
+    if (arena_alloc(&a, sizeof(words)) != NULL || a.used != ARENA_ROUND(5) + 40) return false;
+    arena_release(&a, mark);
+    if (a.used != mark || arena_high_water(&a) != ARENA_ROUND(5) + 40) return false;
+    arena_reset(&a);
+    if (a.used != 0 || arena_high_water(&a) != ARENA_ROUND(5) + 40) return false;
+
+    /* Propane runs the stress layout, the deepest step; it fits a private arena and gives everything back. */
+    Molecule whole;
+    Molecule own;
+    const uint8_t propane[] = {
+        ELEM_C, ELEM_C, ELEM_C, ELEM_H, ELEM_H, ELEM_H, ELEM_H, ELEM_H, ELEM_H, ELEM_H, ELEM_H
+    };
+    uint8_t n = (uint8_t)(sizeof(propane) / sizeof(propane[0]));
+    build_and_generate(&whole, 0, propane, n);
+    build_molecule(&own, 0, propane, n);
+
+    /* Start one byte in, so arena_init() has to align: the buffer size still suffices. */
+    static uint8_t buf[LEWIS_SCRATCH_BYTES + 1];
+    Arena scratch;
+    LewisSolver solver;
+    arena_init(&scratch, buf + 1, LEWIS_SCRATCH_BYTES);
+    if (!lewis_solve_begin(&solver, &own, &scratch)) return false;
+    while (lewis_solve_step(&solver, 1) == LEWIS_SOLVE_IN_PROGRESS) {
+        if (scratch.used != 0) return false;
+    }
+    if (scratch.used != 0 || arena_high_water(&scratch) < (size_t)n * n * 3u) return false;
+    if (!success_invariants(&own) || own.num_res != whole.num_res) return false;
+    for (uint8_t r = 0; r < whole.num_res; r++) {
+        if (!structures_equal(&whole, form_of(&whole, r), form_of(&own, r))) return false;
+        if (memcmp(&whole.layout[r], &own.layout[r], sizeof(AtomLayout)) != 0) return false;
+    }
+
+    /* One byte short is rejected up front: the solver is done and the molecule untouched. */
+    arena_init(&scratch, buf, sizeof(buf));
+    if (arena_alloc(&scratch, scratch.cap - LEWIS_SCRATCH_USE + 1) == NULL) return false;
+    build_molecule(&own, 0, propane, n);
+    Molecule before = own;
+    if (lewis_solve_begin(&solver, &own, &scratch)) return false;
+    if (lewis_solve_step(&solver, UINT16_MAX) != LEWIS_SOLVE_DONE) return false;
+    return memcmp(&own, &before, sizeof(own)) == 0;
+}
+
 static bool test_no_atoms_failure(void)
 {
     Molecule mol;
@@ -766,6 +1674,27 @@ int main(void)
         { "VSEPR SF6", test_vsepr_sf6 },
         { "VSEPR H2 no-null", test_vsepr_h2_no_null },
         { "VSEPR invalid-guard", test_vsepr_invalid_guard },
+        { "Layout CO2 linear", test_layout_co2_linear },
+        { "Layout per resonance form", test_layout_per_resonance_form },
+        { "Lone-pair slots avoid bonds", test_lone_pair_slots_avoid_bonds },
+        { "Display list covers sulfate", test_display_list_sulfate },
+        { "Occupancy counts match cell scan", test_occupancy_counts_match_scan },
+        { "VSEPR projection bends water and SF4", test_layout_vsepr_projection },
+        { "Ring layout draws benzene as a hexagon", test_layout_benzene_ring },
+        { "Ring layout fans four substituents on one vertex apart", test_layout_ring_vertex_fan },
+        { "Stress layout spreads propane", test_layout_stress_propane },
+        { "Packed forms round-trip", test_packed_structure },
+        { "Resonance deltas switch forms", test_resonance_delta },
+        { "Resonance deltas hold a form that changes every field", test_resonance_delta_limit },
+        { "Packed records round-trip", test_pack_round_trip },
+        { "Composition key ignores atom order", test_pack_key_canonical },
+        { "SDF export of carbonate", test_sdf_carbonate },
+        { "SVG export of carbonate", test_svg_carbonate },
+        { "JSON Lines export", test_jsonl_lines },
+        { "LRU result cache persists", test_result_cache },
+        { "SMILES skeleton solves", test_smiles_skeleton },
+        { "Resumable solve matches one-shot", test_resumable_solve_matches },
+        { "Solver scratch arena", test_scratch_arena },
         { "No-atoms failure", test_no_atoms_failure },
         { "Negative-electron failure", test_negative_electrons_failure },
         { "Skeleton failure", test_skeleton_failure },
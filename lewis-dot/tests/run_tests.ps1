@@ -2,11 +2,24 @@ $ErrorActionPreference = "Stop"
 
 $testDir = Split-Path -Parent $MyInvocation.MyCommand.Path
 $srcDir = Join-Path $testDir "..\src"
+$toolDir = Join-Path $testDir "..\tools"
 $outExe = Join-Path $testDir "lewis_engine_tests.exe"
 
 $sources = @(
     (Join-Path $srcDir "lewis_model.c"),
+    (Join-Path $srcDir "arena.c"),
+    (Join-Path $srcDir "fixed_math.c"),
+    (Join-Path $srcDir "layout.c"),
+    (Join-Path $srcDir "display_list.c"),
+    (Join-Path $srcDir "occupancy.c"),
     (Join-Path $srcDir "lewis_engine.c"),
+    (Join-Path $srcDir "lewis_pack.c"),
+    (Join-Path $srcDir "result_cache.c"),
+    (Join-Path $toolDir "out_sink.c"),
+    (Join-Path $toolDir "sdf_writer.c"),
+    (Join-Path $toolDir "jsonl_writer.c"),
+    (Join-Path $toolDir "smiles.c"),
+    (Join-Path $toolDir "svg_writer.c"),
     (Join-Path $testDir "lewis_engine_tests.c")
 )
 
@@ -0,0 +1,78 @@
+#include "corpus.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static int find_element(const char *sym, size_t len)
+{
+    for (int e = 0; e < NUM_ELEMENTS; e++) {
+        if (strlen(elements[e].symbol) == len && strncmp(elements[e].symbol, sym, len) == 0) return e;
+    }
+    return -1;
+}
+
+bool corpus_parse_line(const char *line, Molecule *mol)
+{
+    molecule_reset(mol);
+    const char *p = line;
+    while (*p == ' ' || *p == '\t') p++;
+
+    while (*p >= 'A' && *p <= 'Z') {
+        size_t len = 1;
+        if (p[1] >= 'a' && p[1] <= 'z') len = 2;
+        int e = find_element(p, len);
+        if (e < 0) return false;
+        p += len;
+
+        int count = 0;
+        while (*p >= '0' && *p <= '9') count = count * 10 + (*p++ - '0');
+        if (count == 0) count = 1;
+        if (mol->num_atoms + count > MAX_ATOMS) return false;
+        while (count-- > 0) mol->atoms[mol->num_atoms++].elem = (uint8_t)e;
+    }
+
+    long charge = strtol(p, NULL, 10);
+    if (charge < -8 || charge > 7) return false;
+    mol->charge = (int8_t)charge;
+    return mol->num_atoms > 0;
+}
+
+bool corpus_next(FILE *f, char *line, size_t cap, Molecule *mol)
+{
+    while (fgets(line, (int)cap, f) != NULL) {
+        char *hash = strchr(line, '#');
+        if (hash != NULL) *hash = '\0';
+        line[strcspn(line, "\r\n")] = '\0';
+
+        if (corpus_parse_line(line, mol)) return true;
+    }
+    return false;
+}
+
+static uint32_t lcg_state = 12345u;
+
+static uint32_t lcg_next(void)
+{
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return lcg_state >> 8;
+}
+
+void corpus_random_seed(uint32_t seed)
+{
+    lcg_state = seed;
+}
+
+void corpus_random_molecule(Molecule *mol)
+{
+    static const char *heavy[] = { "C", "N", "O", "S", "P", "F", "Cl", "B", "Se", "Xe", "I" };
+    char buf[64] = "";
+    unsigned n_heavy = 1 + lcg_next() % 4;
+    for (unsigned k = 0; k < n_heavy; k++) {
+        strcat(buf, heavy[lcg_next() % (sizeof(heavy) / sizeof(heavy[0]))]);
+    }
+    unsigned n_h = lcg_next() % 9;
+    if (n_heavy + n_h > MAX_ATOMS) n_h = MAX_ATOMS - n_heavy;
+    if (n_h > 0) sprintf(buf + strlen(buf), "H%u", n_h);
+    sprintf(buf + strlen(buf), " %d", (int)(lcg_next() % 5) - 2);
+    corpus_parse_line(buf, mol);
+}
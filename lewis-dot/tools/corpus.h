@@ -0,0 +1,28 @@
+#ifndef CORPUS_H
+#define CORPUS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "../src/lewis_model.h"
+
+/*
+ * Composition input shared by the host tools. Corpus lines are
+ * "FORMULA [CHARGE]" (for example "SO4 -2"); '#' starts a comment.
+ */
+
+/* Parse one line. False on unknown symbols, too many atoms or no atoms. */
+bool corpus_parse_line(const char *line, Molecule *mol);
+
+/*
+ * Read lines from f until one parses; the comment-stripped text is left in
+ * line for labels. False at end of file.
+ */
+bool corpus_next(FILE *f, char *line, size_t cap, Molecule *mol);
+
+/* Deterministic random compositions (1-4 heavy atoms, 0-8 H, charge -2..2). */
+void corpus_random_seed(uint32_t seed);
+void corpus_random_molecule(Molecule *mol);
+
+#endif
@@ -0,0 +1,232 @@
+/*
+ * Host-side batch JSON Lines export.
+ *
+ * Loads a corpus (and --random N more), splits it into one contiguous
+ * slice per thread, and has every thread solve its slice and format it
+ * through jsonl_writer.c into its own OutSink. The slices are written to
+ * the output file in corpus order after the threads join; without an
+ * output file the lines are formatted and discarded. Each thread solves on
+ * its own scratch arena, reset once per batch. Prints lines, bytes,
+ * wall-clock molecules per second, per-thread solver and writer rates, and
+ * the deepest scratch use.
+ *
+ *   jsonl_export corpus.txt [out.jsonl] [--threads T] [--random N [SEED]]
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#include "../src/lewis_engine.h"
+#include "../src/lewis_model.h"
+#include "out_sink.h"
+#include "jsonl_writer.h"
+#include "corpus.h"
+
+#define MAX_THREADS 64
+
+typedef struct {
+    Molecule *mols;
+    size_t count;
+    bool keep;          /* collect output for the file */
+    char *text;         /* collected output, grown by collect() */
+    size_t text_len;
+    size_t text_cap;
+    bool ok;
+    double solve_nanos;
+    double write_nanos;
+    size_t scratch_peak; /* arena high-water mark for the batch */
+    char buf[1 << 16];  /* the sink buffer */
+    uint8_t scratch_buf[LEWIS_SCRATCH_BYTES];
+} Worker;
+
+static double now_nanos(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static bool collect(void *ctx, const char *data, size_t len)
+{
+    Worker *w = (Worker *)ctx;
+    if (!w->keep) return true;
+    if (w->text_len + len > w->text_cap) {
+        size_t cap = w->text_cap ? w->text_cap * 2 : (1u << 20);
+        while (cap < w->text_len + len) cap *= 2;
+        char *grown = (char *)realloc(w->text, cap);
+        if (grown == NULL) return false;
+        w->text = grown;
+        w->text_cap = cap;
+    }
+    memcpy(w->text + w->text_len, data, len);
+    w->text_len += len;
+    return true;
+}
+
+static void run_worker(Worker *w)
+{
+    OutSink out;
+    Arena scratch;
+    LewisSolver solver;
+    out_sink_init(&out, w->buf, sizeof(w->buf), collect, w);
+    arena_init(&scratch, w->scratch_buf, sizeof(w->scratch_buf));
+    w->ok = true;
+    for (size_t k = 0; w->ok && k < w->count; k++) {
+        double t0 = now_nanos();
+        if (!lewis_solve_begin(&solver, &w->mols[k], &scratch)) {
+            w->ok = false;
+            break;
+        }
+        while (lewis_solve_step(&solver, UINT16_MAX) != LEWIS_SOLVE_DONE) {
+        }
+        double t1 = now_nanos();
+        w->ok = jsonl_write_molecule(&out, &w->mols[k]);
+        double t2 = now_nanos();
+        w->solve_nanos += t1 - t0;
+        w->write_nanos += t2 - t1;
+    }
+    w->ok = out_sink_flush(&out) && w->ok;
+    w->scratch_peak = arena_high_water(&scratch);
+    arena_reset(&scratch);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI worker_main(LPVOID arg)
+{
+    run_worker((Worker *)arg);
+    return 0;
+}
+#else
+static void *worker_main(void *arg)
+{
+    run_worker((Worker *)arg);
+    return NULL;
+}
+#endif
+
+static Molecule *mols;
+static size_t mol_count;
+static size_t mol_cap;
+
+static bool push_molecule(const Molecule *mol)
+{
+    if (mol_count == mol_cap) {
+        size_t cap = mol_cap ? mol_cap * 2 : 1024;
+        Molecule *grown = (Molecule *)realloc(mols, cap * sizeof(*mols));
+        if (grown == NULL) return false;
+        mols = grown;
+        mol_cap = cap;
+    }
+    mols[mol_count++] = *mol;
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    const char *corpus = NULL;
+    const char *path = NULL;
+    unsigned long random_n = 0;
+    unsigned threads = 1;
+
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "--random") == 0 && a + 1 < argc) {
+            random_n = strtoul(argv[++a], NULL, 10);
+            if (a + 1 < argc && argv[a + 1][0] != '-') corpus_random_seed((uint32_t)strtoul(argv[++a], NULL, 10));
+        } else if (strcmp(argv[a], "--threads") == 0 && a + 1 < argc) {
+            threads = (unsigned)strtoul(argv[++a], NULL, 10);
+        } else if (corpus == NULL) {
+            corpus = argv[a];
+        } else {
+            path = argv[a];
+        }
+    }
+    if (corpus == NULL || threads == 0 || threads > MAX_THREADS) {
+        fprintf(stderr, "usage: jsonl_export corpus.txt [out.jsonl] [--threads 1-%d] [--random N [SEED]]\n", MAX_THREADS);
+        return 1;
+    }
+
+    FILE *f = fopen(corpus, "r");
+    if (f == NULL) {
+        fprintf(stderr, "cannot open %s\n", corpus);
+        return 1;
+    }
+    char line[128];
+    Molecule mol;
+    bool ok = true;
+    while (ok && corpus_next(f, line, sizeof(line), &mol)) ok = push_molecule(&mol);
+    fclose(f);
+    for (unsigned long k = 0; ok && k < random_n; k++) {
+        corpus_random_molecule(&mol);
+        ok = push_molecule(&mol);
+    }
+    Worker *workers = (Worker *)calloc(threads, sizeof(*workers));
+    if (!ok || workers == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    for (unsigned t = 0; t < threads; t++) {
+        size_t first = mol_count * t / threads;
+        workers[t].mols = mols + first;
+        workers[t].count = mol_count * (t + 1) / threads - first;
+        workers[t].keep = path != NULL;
+    }
+
+    double t0 = now_nanos();
+#ifdef _WIN32
+    HANDLE handles[MAX_THREADS];
+    for (unsigned t = 0; t < threads; t++) handles[t] = CreateThread(NULL, 0, worker_main, &workers[t], 0, NULL);
+    for (unsigned t = 0; t < threads; t++) {
+        WaitForSingleObject(handles[t], INFINITE);
+        CloseHandle(handles[t]);
+    }
+#else
+    pthread_t handles[MAX_THREADS];
+    for (unsigned t = 0; t < threads; t++) pthread_create(&handles[t], NULL, worker_main, &workers[t]);
+    for (unsigned t = 0; t < threads; t++) pthread_join(handles[t], NULL);
+#endif
+    double wall = now_nanos() - t0;
+
+    unsigned long bytes = 0;
+    double solve_nanos = 0.0;
+    double write_nanos = 0.0;
+    size_t scratch_peak = 0;
+    FILE *o = NULL;
+    if (path != NULL && (o = fopen(path, "wb")) == NULL) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return 1;
+    }
+    for (unsigned t = 0; t < threads; t++) {
+        Worker *w = &workers[t];
+        ok = ok && w->ok;
+        if (o != NULL && ok) ok = fwrite(w->text, 1, w->text_len, o) == w->text_len;
+        bytes += (unsigned long)w->text_len;
+        solve_nanos += w->solve_nanos;
+        write_nanos += w->write_nanos;
+        if (w->scratch_peak > scratch_peak) scratch_peak = w->scratch_peak;
+        free(w->text);
+    }
+    if (o != NULL && fclose(o) != 0) ok = false;
+    free(workers);
+    free(mols);
+    if (!ok) {
+        fprintf(stderr, "write failed\n");
+        return 1;
+    }
+
+    printf("lines %lu, bytes %lu, threads %u\n", (unsigned long)mol_count, bytes, threads);
+    printf("wall %.0f molecules/s; per thread: solve %.0f molecules/s, jsonl %.0f lines/s\n",
+           wall > 0.0 ? mol_count * 1e9 / wall : 0.0,
+           solve_nanos > 0.0 ? mol_count * 1e9 / solve_nanos : 0.0,
+           write_nanos > 0.0 ? mol_count * 1e9 / write_nanos : 0.0);
+    printf("scratch high water %lu of %lu bytes\n", (unsigned long)scratch_peak, (unsigned long)LEWIS_SCRATCH_USE);
+    return 0;
+}
@@ -0,0 +1,157 @@
+#include "jsonl_writer.h"
+
+#include "../src/lewis_engine.h"
+
+/* JSON string; NULL becomes null. Control characters use \u00XX. */
+static void put_string(OutSink *out, const char *s)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    if (s == NULL) {
+        out_sink_puts(out, "null");
+        return;
+    }
+    out_sink_putc(out, '"');
+    for (; *s != '\0'; s++) {
+        char c = *s;
+        if (c == '"' || c == '\\') {
+            out_sink_putc(out, '\\');
+            out_sink_putc(out, c);
+        } else if ((unsigned char)c < 0x20) {
+            out_sink_puts(out, "\\u00");
+            out_sink_putc(out, hex[(unsigned char)c >> 4]);
+            out_sink_putc(out, hex[c & 0xF]);
+        } else {
+            out_sink_putc(out, c);
+        }
+    }
+    out_sink_putc(out, '"');
+}
+
+static void put_key(OutSink *out, const char *key)
+{
+    out_sink_putc(out, '"');
+    out_sink_puts(out, key);
+    out_sink_puts(out, "\":");
+}
+
+static void put_form(OutSink *out, const Molecule *mol, const LewisStructure *ls)
+{
+    out_sink_putc(out, '{');
+    put_key(out, "bonds");
+    out_sink_putc(out, '[');
+    for (uint8_t k = 0; k < ls->num_bonds; k++) {
+        if (k > 0) out_sink_putc(out, ',');
+        out_sink_putc(out, '[');
+        out_sink_put_int(out, ls->bonds[k].a, 0);
+        out_sink_putc(out, ',');
+        out_sink_put_int(out, ls->bonds[k].b, 0);
+        out_sink_putc(out, ',');
+        out_sink_put_int(out, ls->bonds[k].order, 0);
+        out_sink_putc(out, ']');
+    }
+    out_sink_puts(out, "],");
+    put_key(out, "lone_pairs");
+    out_sink_putc(out, '[');
+    for (uint8_t i = 0; i < mol->num_atoms; i++) {
+        if (i > 0) out_sink_putc(out, ',');
+        out_sink_put_int(out, ls->lone_pairs[i], 0);
+    }
+    out_sink_puts(out, "],");
+    put_key(out, "formal_charges");
+    out_sink_putc(out, '[');
+    for (uint8_t i = 0; i < mol->num_atoms; i++) {
+        if (i > 0) out_sink_putc(out, ',');
+        out_sink_put_int(out, ls->formal_charge[i], 0);
+    }
+    out_sink_puts(out, "]}");
+}
+
+static void put_vsepr(OutSink *out, const Molecule *mol)
+{
+    VseprInfo info;
+    LewisStructure first;
+    if (mol->num_res > 0) molecule_form(mol, 0, &first);
+    if (mol->num_res == 0 || !lewis_get_vsepr_info(mol, &first, &info)) {
+        out_sink_puts(out, "null");
+        return;
+    }
+    out_sink_putc(out, '{');
+    put_key(out, "electron_pairs");
+    out_sink_put_int(out, info.valence_pairs, 0);
+    out_sink_putc(out, ',');
+    put_key(out, "bond_pairs");
+    out_sink_put_int(out, info.bond_pairs, 0);
+    out_sink_putc(out, ',');
+    put_key(out, "lone_pairs");
+    out_sink_put_int(out, info.lone_pairs, 0);
+    out_sink_putc(out, ',');
+    put_key(out, "electron_geometry");
+    put_string(out, info.ep_geometry);
+    out_sink_putc(out, ',');
+    put_key(out, "shape");
+    put_string(out, info.shape);
+    out_sink_putc(out, ',');
+    put_key(out, "hybridization");
+    put_string(out, info.hybridization);
+    out_sink_putc(out, ',');
+    put_key(out, "bond_angle");
+    put_string(out, info.bond_angle);
+    out_sink_putc(out, '}');
+}
+
+bool jsonl_write_molecule(OutSink *out, const Molecule *mol)
+{
+    OutMark start = out_sink_mark(out);
+    char formula[MOLECULE_FORMULA_MAX];
+    molecule_formula(mol, formula);
+
+    out_sink_putc(out, '{');
+    put_key(out, "formula");
+    put_string(out, formula);
+    out_sink_putc(out, ',');
+    put_key(out, "charge");
+    out_sink_put_int(out, mol->charge, 0);
+    out_sink_putc(out, ',');
+    put_key(out, "total_ve");
+    out_sink_put_int(out, mol->total_ve, 0);
+    out_sink_putc(out, ',');
+    put_key(out, "central");
+    if (mol->num_res > 0) out_sink_put_int(out, mol->central, 0);
+    else out_sink_puts(out, "null");
+    out_sink_putc(out, ',');
+
+    put_key(out, "atoms");
+    out_sink_putc(out, '[');
+    for (uint8_t i = 0; i < mol->num_atoms; i++) {
+        if (i > 0) out_sink_putc(out, ',');
+        put_string(out, elements[mol->atoms[i].elem].symbol);
+    }
+    out_sink_puts(out, "],");
+
+    put_key(out, "forms");
+    out_sink_putc(out, '[');
+    /* Walk the forms on one unpacked copy, switching by delta. */
+    LewisStructure ls;
+    if (mol->num_res > 0) molecule_form(mol, 0, &ls);
+    for (uint8_t r = 0; r < mol->num_res; r++) {
+        if (r > 0) out_sink_putc(out, ',');
+        resonance_apply(mol, r, &ls);
+        put_form(out, mol, &ls);
+        resonance_revert(mol, r, &ls);
+    }
+    out_sink_puts(out, "],");
+
+    put_key(out, "vsepr");
+    put_vsepr(out, mol);
+    out_sink_putc(out, ',');
+    put_key(out, "invalid_reason");
+    put_string(out, mol->num_res > 0 ? NULL : invalid_reason_message(mol->invalid_reason));
+    out_sink_puts(out, "}\n");
+
+    if (out->failed) {
+        out_sink_rollback(out, start);
+        return false;
+    }
+    return true;
+}
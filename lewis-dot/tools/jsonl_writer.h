@@ -0,0 +1,34 @@
+#ifndef JSONL_WRITER_H
+#define JSONL_WRITER_H
+
+#include <stdbool.h>
+
+#include "../src/lewis_model.h"
+#include "out_sink.h"
+
+/*
+ * JSON Lines export: one object per molecule, one line per object.
+ *
+ *   {"formula":"CO3","charge":-2,"total_ve":24,"central":0,
+ *    "atoms":["C","O","O","O"],
+ *    "forms":[{"bonds":[[0,1,2],...],"lone_pairs":[...],
+ *              "formal_charges":[...]},...],
+ *    "vsepr":{"electron_pairs":3,"bond_pairs":3,"lone_pairs":0,
+ *             "electron_geometry":"Trigonal Planar","shape":"Trigonal Planar",
+ *             "hybridization":"sp2","bond_angle":"120"},
+ *    "invalid_reason":null}
+ *
+ * Atom indices are 0-based. VSEPR fields come from lewis_get_vsepr_info()
+ * on the first form. A molecule without forms has "central":null,
+ * "forms":[], "vsepr":null and the invalid_reason_message() text.
+ * Numbers go through out_sink_put_int; the writer keeps no state, so
+ * threads can each format into their own sink.
+ */
+
+/*
+ * Append the line for mol. On failure the sink is rolled back to the line
+ * start when nothing of it was flushed.
+ */
+bool jsonl_write_molecule(OutSink *out, const Molecule *mol);
+
+#endif
@@ -0,0 +1,320 @@
+/*
+ * Host-side layout quality and speed benchmark.
+ *
+ * Solves every composition of a corpus, then runs each layout function in
+ * layout.c over every resonance form and reports, per layout mode:
+ *   - bond crossings (segments that properly intersect),
+ *   - the minimum distance between two atoms,
+ *   - atoms whose centre falls outside SCR_W x SCR_H,
+ *   - lone-pair dots that hit another dot, a bond or a symbol box,
+ *   - the mean time of one layout call.
+ *
+ * Corpus lines are "FORMULA [CHARGE]" (for example "SO4 -2"); '#' starts a
+ * comment. --random N [SEED] adds N generated compositions instead, for
+ * large runs. Metrics are integer-only and cost O(bonds^2 + dots * bonds)
+ * per form, so 100k structures take seconds.
+ *
+ *   layout_bench [corpus.txt] [--random N [SEED]] [--repeat R] [--verbose]
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/layout.h"
+#include "../src/lewis_engine.h"
+#include "../src/lewis_model.h"
+#include "corpus.h"
+
+typedef bool (*LayoutFn)(const Molecule *mol, const LewisStructure *ls, AtomLayout *out);
+
+static bool run_structure(const Molecule *mol, const LewisStructure *ls, AtomLayout *out)
+{
+    layout_structure(mol, ls, out, lewis_scratch());
+    return true;
+}
+
+static bool run_radial(const Molecule *mol, const LewisStructure *ls, AtomLayout *out)
+{
+    (void)ls;
+    layout_radial(mol, out);
+    return true;
+}
+
+static bool run_rings(const Molecule *mol, const LewisStructure *ls, AtomLayout *out)
+{
+    return layout_rings(mol, ls, out, lewis_scratch());
+}
+
+static bool run_tree_stress(const Molecule *mol, const LewisStructure *ls, AtomLayout *out)
+{
+    if (!layout_tree_from_central(mol, ls, out)) return false;
+    layout_stress(mol, ls, out, LAYOUT_STRESS_SWEEPS, lewis_scratch());
+    return true;
+}
+
+typedef struct {
+    const char *name;
+    LayoutFn fn;
+    bool ranks_lone_pairs; /* the call already ranks lone-pair slots */
+} Mode;
+
+static const Mode modes[] = {
+    { "structure",   run_structure,            true },
+    { "vsepr",       layout_vsepr,             false },
+    { "rings",       run_rings,                false },
+    { "chain",       layout_linear_chain,      false },
+    { "tree",        layout_tree_from_central, false },
+    { "tree+stress", run_tree_stress,          false },
+    { "radial",      run_radial,               false },
+};
+
+#define NUM_MODES (sizeof(modes) / sizeof(modes[0]))
+
+typedef struct {
+    unsigned long forms;          /* forms the mode produced a layout for */
+    unsigned long crossings;
+    unsigned long crossed_forms;
+    unsigned long offscreen;
+    unsigned long lp_collisions;
+    long worst_min_d2;            /* smallest squared atom distance seen */
+    double sum_min_d;
+    double nanos;
+    unsigned long calls;
+} ModeStats;
+
+typedef struct {
+    unsigned crossings;
+    long min_d2;
+    unsigned offscreen;
+    unsigned lp_collisions;
+} Metrics;
+
+/* ---- geometry, all integer ---- */
+
+static long orient(long ax, long ay, long bx, long by, long cx, long cy)
+{
+    long v = (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
+    return (v > 0) - (v < 0);
+}
+
+static bool segments_cross(const AtomLayout *l, const Bond *p, const Bond *q)
+{
+    if (p->a == q->a || p->a == q->b || p->b == q->a || p->b == q->b) return false;
+
+    long o1 = orient(l->x[p->a], l->y[p->a], l->x[p->b], l->y[p->b], l->x[q->a], l->y[q->a]);
+    long o2 = orient(l->x[p->a], l->y[p->a], l->x[p->b], l->y[p->b], l->x[q->b], l->y[q->b]);
+    long o3 = orient(l->x[q->a], l->y[q->a], l->x[q->b], l->y[q->b], l->x[p->a], l->y[p->a]);
+    long o4 = orient(l->x[q->a], l->y[q->a], l->x[q->b], l->y[q->b], l->x[p->b], l->y[p->b]);
+    return o1 * o2 < 0 && o3 * o4 < 0;
+}
+
+/* True when point (px, py) lies within r of segment a-b. */
+static bool near_segment(long px, long py, long ax, long ay, long bx, long by, long r)
+{
+    long dx = bx - ax;
+    long dy = by - ay;
+    long len2 = dx * dx + dy * dy;
+    long t = (px - ax) * dx + (py - ay) * dy;
+
+    if (len2 == 0 || t <= 0) return (px - ax) * (px - ax) + (py - ay) * (py - ay) <= r * r;
+    if (t >= len2) return (px - bx) * (px - bx) + (py - by) * (py - by) <= r * r;
+
+    long cross = (px - ax) * dy - (py - ay) * dx;
+    return cross * cross <= r * r * len2;
+}
+
+static void measure(const Molecule *mol, const LewisStructure *ls, const AtomLayout *l, Metrics *m)
+{
+    memset(m, 0, sizeof(*m));
+    m->min_d2 = -1;
+
+    for (uint8_t i = 0; i < mol->num_atoms; i++) {
+        if (l->x[i] < 0 || l->x[i] >= SCR_W || l->y[i] < 0 || l->y[i] >= SCR_H) m->offscreen++;
+        for (uint8_t j = i + 1; j < mol->num_atoms; j++) {
+            long dx = l->x[i] - l->x[j];
+            long dy = l->y[i] - l->y[j];
+            long d2 = dx * dx + dy * dy;
+            if (m->min_d2 < 0 || d2 < m->min_d2) m->min_d2 = d2;
+        }
+    }
+
+    for (uint8_t b = 0; b < ls->num_bonds; b++) {
+        for (uint8_t c = b + 1; c < ls->num_bonds; c++) {
+            if (segments_cross(l, &ls->bonds[b], &ls->bonds[c])) m->crossings++;
+        }
+    }
+
+    /* Every dot of every pair, with its owner, so dots of one atom are not tested against each other. */
+    int dots[MAX_ATOMS * LP_MAX_SLOTS * 2][2];
+    uint8_t owner[MAX_ATOMS * LP_MAX_SLOTS * 2];
+    unsigned n_dots = 0;
+    for (uint8_t i = 0; i < mol->num_atoms; i++) {
+        for (uint8_t lp = 0; lp < ls->lone_pairs[i] && lp < LP_MAX_SLOTS; lp++) {
+            int d[4];
+            layout_lone_pair_dots(l, i, lp, d);
+            dots[n_dots][0] = d[0];
+            dots[n_dots][1] = d[1];
+            owner[n_dots++] = i;
+            dots[n_dots][0] = d[2];
+            dots[n_dots][1] = d[3];
+            owner[n_dots++] = i;
+        }
+    }
+
+    for (unsigned k = 0; k < n_dots; k++) {
+        long px = dots[k][0];
+        long py = dots[k][1];
+        bool hit = false;
+
+        for (unsigned o = 0; o < n_dots && !hit; o++) {
+            if (owner[o] == owner[k]) continue;
+            long dx = px - dots[o][0];
+            long dy = py - dots[o][1];
+            hit = dx * dx + dy * dy <= (2 * DOT_R + 1) * (2 * DOT_R + 1);
+        }
+        for (uint8_t b = 0; b < ls->num_bonds && !hit; b++) {
+            const Bond *bd = &ls->bonds[b];
+            hit = near_segment(px, py, l->x[bd->a], l->y[bd->a], l->x[bd->b], l->y[bd->b], DOT_R + 1);
+        }
+        for (uint8_t i = 0; i < mol->num_atoms && !hit; i++) {
+            if (i == owner[k]) continue;
+            long half_w = (long)strlen(elements[mol->atoms[i].elem].symbol) * 4 + 1 + DOT_R;
+            long half_h = 5 + DOT_R;
+            hit = labs(px - l->x[i]) <= half_w && labs(py - l->y[i]) <= half_h;
+        }
+        if (hit) m->lp_collisions++;
+    }
+}
+
+/* ---- driver ---- */
+
+static double now_nanos(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static ModeStats stats[NUM_MODES];
+static unsigned long compositions;
+static unsigned long solved;
+static unsigned long total_forms;
+
+static void bench_molecule(Molecule *mol, const char *label, unsigned repeat, bool verbose)
+{
+    compositions++;
+    generate_resonance(mol);
+    if (mol->num_res == 0) return;
+    solved++;
+
+    for (uint8_t r = 0; r < mol->num_res; r++) {
+        LewisStructure form;
+        molecule_form(mol, r, &form);
+        const LewisStructure *ls = &form;
+        total_forms++;
+
+        for (size_t m = 0; m < NUM_MODES; m++) {
+            AtomLayout lay;
+            bool ok = true;
+
+            double t0 = now_nanos();
+            for (unsigned k = 0; k < repeat; k++) {
+                memset(&lay, 0, sizeof(lay));
+                ok = modes[m].fn(mol, ls, &lay);
+            }
+            stats[m].nanos += now_nanos() - t0;
+            stats[m].calls += repeat;
+            if (!ok) continue;
+
+            if (!modes[m].ranks_lone_pairs) layout_rank_lone_pairs(mol, ls, &lay);
+
+            Metrics met;
+            measure(mol, ls, &lay, &met);
+            ModeStats *st = &stats[m];
+            st->forms++;
+            st->crossings += met.crossings;
+            if (met.crossings > 0) st->crossed_forms++;
+            st->offscreen += met.offscreen;
+            st->lp_collisions += met.lp_collisions;
+            if (met.min_d2 >= 0) {
+                if (st->worst_min_d2 < 0 || met.min_d2 < st->worst_min_d2) st->worst_min_d2 = met.min_d2;
+                double d = 0.0;
+                while ((d + 1.0) * (d + 1.0) <= (double)met.min_d2) d += 1.0;
+                st->sum_min_d += d;
+            }
+
+            if (verbose) {
+                printf("%-14s res %u %-11s cross %u  min %ld px^2  off %u  lp %u\n",
+                       label, r + 1, modes[m].name, met.crossings, met.min_d2, met.offscreen, met.lp_collisions);
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *corpus = NULL;
+    unsigned long random_n = 0;
+    unsigned repeat = 1;
+    bool verbose = false;
+
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "--random") == 0 && a + 1 < argc) {
+            random_n = strtoul(argv[++a], NULL, 10);
+            if (a + 1 < argc && argv[a + 1][0] != '-') corpus_random_seed((uint32_t)strtoul(argv[++a], NULL, 10));
+        } else if (strcmp(argv[a], "--repeat") == 0 && a + 1 < argc) {
+            repeat = (unsigned)strtoul(argv[++a], NULL, 10);
+            if (repeat == 0) repeat = 1;
+        } else if (strcmp(argv[a], "--verbose") == 0) {
+            verbose = true;
+        } else {
+            corpus = argv[a];
+        }
+    }
+
+    for (size_t m = 0; m < NUM_MODES; m++) stats[m].worst_min_d2 = -1;
+
+    if (corpus != NULL) {
+        FILE *f = fopen(corpus, "r");
+        if (f == NULL) {
+            fprintf(stderr, "cannot open %s\n", corpus);
+            return 1;
+        }
+        char line[128];
+        Molecule mol;
+        while (corpus_next(f, line, sizeof(line), &mol)) {
+            bench_molecule(&mol, line, repeat, verbose);
+        }
+        fclose(f);
+    }
+
+    for (unsigned long k = 0; k < random_n; k++) {
+        Molecule mol;
+        corpus_random_molecule(&mol);
+        bench_molecule(&mol, "random", repeat, verbose);
+    }
+
+    printf("compositions %lu, solved %lu, resonance forms %lu\n\n", compositions, solved, total_forms);
+    printf("%-11s %7s %8s %8s %8s %9s %8s %8s %9s\n",
+           "mode", "forms", "cross", "crossed", "min px", "mean min", "offscr", "lp hits", "ns/call");
+
+    for (size_t m = 0; m < NUM_MODES; m++) {
+        const ModeStats *st = &stats[m];
+        long worst = 0;
+        while (st->worst_min_d2 >= 0 && (worst + 1) * (worst + 1) <= st->worst_min_d2) worst++;
+
+        printf("%-11s %7lu %8lu %8lu %8ld %9.1f %8lu %8lu %9.0f\n",
+               modes[m].name,
+               st->forms,
+               st->crossings,
+               st->crossed_forms,
+               worst,
+               st->forms ? st->sum_min_d / (double)st->forms : 0.0,
+               st->offscreen,
+               st->lp_collisions,
+               st->calls ? st->nanos / (double)st->calls : 0.0);
+    }
+    return 0;
+}
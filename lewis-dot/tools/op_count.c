@@ -0,0 +1,319 @@
+/*
+ * Host-side operation counter for the per-frame geometry path.
+ *
+ * The former draw_lewis() laid the molecule out and computed bond offsets
+ * on every frame; a replica of those division-based formulas counts its
+ * divides. Layouts are now computed once per solve and stored, so the
+ * fixed-point side is counted in two parts: layout_structure once per
+ * resonance form, and display_list_build, the per-frame render path, on
+ * the stored layout. Each fixed-point divide is one reciprocal lookup.
+ *
+ * The replica's tree layout is also checked pixel by pixel against
+ * layout_tree_from_central, the helper it was converted into; the other
+ * layout modes have no division-based counterpart to compare with.
+ *
+ * Build with -DLEWIS_OP_COUNT (see run_op_count.ps1).
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/display_list.h"
+#include "../src/fixed_math.h"
+#include "../src/layout.h"
+#include "../src/lewis_engine.h"
+#include "../src/lewis_model.h"
+
+static unsigned long old_divs;
+#define OLD_DIV(a, b) (old_divs++, (a) / (b))
+
+static const int16_t old_cos[12] = { 256, 222, 128, 0, -128, -222, -256, -222, -128, 0, 128, 222 };
+static const int16_t old_sin[12] = { 0, 128, 222, 256, 222, 128, 0, -128, -222, -256, -222, -128 };
+
+static bool old_chain(const Molecule *mol, const LewisStructure *ls, int ax[], int ay[])
+{
+    if (mol->num_atoms < 3 || ls->num_bonds != mol->num_atoms - 1) return false;
+
+    uint8_t deg[MAX_ATOMS] = { 0 };
+    int8_t neigh[MAX_ATOMS][2];
+    memset(neigh, -1, sizeof(neigh));
+    for (uint8_t b = 0; b < ls->num_bonds; b++) {
+        uint8_t a = ls->bonds[b].a;
+        uint8_t c = ls->bonds[b].b;
+        if (deg[a] >= 2 || deg[c] >= 2) return false;
+        neigh[a][deg[a]++] = (int8_t)c;
+        neigh[c][deg[c]++] = (int8_t)a;
+    }
+
+    int start = -1;
+    int endpoints = 0;
+    for (uint8_t i = 0; i < mol->num_atoms; i++) {
+        if (deg[i] == 1) {
+            endpoints++;
+            if (start < 0) start = i;
+        } else if (deg[i] != 2) {
+            return false;
+        }
+    }
+    if (endpoints != 2) return false;
+
+    int step = OLD_DIV(SCR_W - 80, mol->num_atoms - 1);
+    if (step > BOND_LEN) step = BOND_LEN;
+    if (step < 22) step = 22;
+    int x0 = LEWIS_CENTER_X - OLD_DIV(step * (mol->num_atoms - 1), 2);
+
+    int prev = -1;
+    int cur = start;
+    for (uint8_t k = 0; k < mol->num_atoms && cur >= 0; k++) {
+        ax[cur] = x0 + k * step;
+        ay[cur] = LEWIS_CENTER_Y;
+        int next = -1;
+        for (uint8_t ni = 0; ni < deg[cur]; ni++) {
+            if (neigh[cur][ni] != prev) {
+                next = neigh[cur][ni];
+                break;
+            }
+        }
+        prev = cur;
+        cur = next;
+    }
+    return true;
+}
+
+static bool old_tree(const Molecule *mol, const LewisStructure *ls, int ax[], int ay[])
+{
+    int8_t dist[MAX_ATOMS];
+    int8_t parent[MAX_ATOMS];
+    uint8_t q[MAX_ATOMS];
+    uint8_t qh = 0;
+    uint8_t qt = 0;
+    memset(dist, -1, sizeof(dist));
+    memset(parent, -1, sizeof(parent));
+    dist[mol->central] = 0;
+    q[qt++] = mol->central;
+    while (qh < qt) {
+        uint8_t u = q[qh++];
+        for (uint8_t b = 0; b < ls->num_bonds; b++) {
+            int v = -1;
+            if (ls->bonds[b].a == u) v = ls->bonds[b].b;
+            else if (ls->bonds[b].b == u) v = ls->bonds[b].a;
+            if (v < 0 || dist[v] != -1) continue;
+            dist[v] = (int8_t)(dist[u] + 1);
+            parent[v] = (int8_t)u;
+            q[qt++] = (uint8_t)v;
+        }
+    }
+
+    int max_dist = 0;
+    uint8_t n_first = 0;
+    for (uint8_t i = 0; i < mol->num_atoms; i++) {
+        if (dist[i] < 0) return false;
+        if (dist[i] > max_dist) max_dist = dist[i];
+        if (dist[i] == 1) n_first++;
+    }
+
+    ax[mol->central] = LEWIS_CENTER_X;
+    ay[mol->central] = LEWIS_CENTER_Y;
+    uint8_t k = 0;
+    for (uint8_t i = 0; i < mol->num_atoms; i++) {
+        if (dist[i] != 1) continue;
+        int angle_idx = OLD_DIV(k * 12, n_first);
+        ax[i] = LEWIS_CENTER_X + OLD_DIV(old_cos[angle_idx] * BOND_LEN, 256);
+        ay[i] = LEWIS_CENTER_Y + OLD_DIV(old_sin[angle_idx] * BOND_LEN, 256);
+        k++;
+    }
+
+    for (int d = 2; d <= max_dist; d++) {
+        for (uint8_t i = 0; i < mol->num_atoms; i++) {
+            if (dist[i] != d) continue;
+            int p = parent[i];
+            int dx = ax[p] - LEWIS_CENTER_X;
+            int dy = ay[p] - LEWIS_CENTER_Y;
+            if (dx == 0 && dy == 0) dx = 1;
+            int len = abs(dx) > abs(dy) ? abs(dx) : abs(dy);
+            int bx = ax[p] + OLD_DIV(dx * BOND_LEN, len);
+            int by = ay[p] + OLD_DIV(dy * BOND_LEN, len);
+
+            int sib_count = 0;
+            int sib_idx = 0;
+            for (uint8_t j = 0; j < mol->num_atoms; j++) {
+                if (dist[j] == d && parent[j] == p) {
+                    if (j == i) sib_idx = sib_count;
+                    sib_count++;
+                }
+            }
+            if (sib_count > 1) {
+                int pdx = -dy;
+                int pdy = dx;
+                int plen = abs(pdx) > abs(pdy) ? abs(pdx) : abs(pdy);
+                int spread = (sib_idx * 2 - (sib_count - 1)) * 8;
+                bx += OLD_DIV(pdx * spread, plen);
+                by += OLD_DIV(pdy * spread, plen);
+            }
+            ax[i] = bx;
+            ay[i] = by;
+        }
+    }
+    return true;
+}
+
+static void old_frame(const Molecule *mol, const LewisStructure *ls, int ax[], int ay[])
+{
+    bool has_multiple = false;
+    for (uint8_t b = 0; b < ls->num_bonds; b++) {
+        if (ls->bonds[b].order > 1) has_multiple = true;
+    }
+
+    if (mol->num_atoms == 1) {
+        ax[0] = LEWIS_CENTER_X;
+        ay[0] = LEWIS_CENTER_Y;
+    } else if (mol->num_atoms == 2) {
+        ax[0] = LEWIS_CENTER_X - OLD_DIV(BOND_LEN, 2);
+        ax[1] = LEWIS_CENTER_X + OLD_DIV(BOND_LEN, 2);
+        ay[0] = ay[1] = LEWIS_CENTER_Y;
+    } else if (!(has_multiple && old_chain(mol, ls, ax, ay)) && !old_tree(mol, ls, ax, ay)) {
+        ax[mol->central] = LEWIS_CENTER_X;
+        ay[mol->central] = LEWIS_CENTER_Y;
+        int n_term = mol->num_atoms - 1;
+        int t = 0;
+        for (uint8_t i = 0; i < mol->num_atoms; i++) {
+            if (i == mol->central) continue;
+            int angle_idx = OLD_DIV(t * 12, n_term);
+            ax[i] = LEWIS_CENTER_X + OLD_DIV(old_cos[angle_idx] * BOND_LEN, 256);
+            ay[i] = LEWIS_CENTER_Y + OLD_DIV(old_sin[angle_idx] * BOND_LEN, 256);
+            t++;
+        }
+    }
+
+    /* Former multiple-bond offsets in draw_lewis(): two divides per bond. */
+    for (uint8_t b = 0; b < ls->num_bonds; b++) {
+        if (ls->bonds[b].order < 2) continue;
+        int px = -(ay[ls->bonds[b].b] - ay[ls->bonds[b].a]);
+        int py = ax[ls->bonds[b].b] - ax[ls->bonds[b].a];
+        int len = abs(px) > abs(py) ? abs(px) : abs(py);
+        if (len == 0) len = 1;
+        int dist = (ls->bonds[b].order == 2) ? 3 : 4;
+        (void)OLD_DIV(px * dist, len);
+        (void)OLD_DIV(py * dist, len);
+    }
+}
+
+typedef struct {
+    const char *name;
+    int8_t charge;
+    uint8_t count;
+    uint8_t atoms[MAX_ATOMS];
+} Sample;
+
+static const Sample samples[] = {
+    { "H2",     0, 2, { ELEM_H, ELEM_H } },
+    { "H2O",    0, 3, { ELEM_O, ELEM_H, ELEM_H } },
+    { "NH3",    0, 4, { ELEM_N, ELEM_H, ELEM_H, ELEM_H } },
+    { "CH4",    0, 5, { ELEM_C, ELEM_H, ELEM_H, ELEM_H, ELEM_H } },
+    { "CO2",    0, 3, { ELEM_C, ELEM_O, ELEM_O } },
+    { "NO3-",  -1, 4, { ELEM_N, ELEM_O, ELEM_O, ELEM_O } },
+    { "CO3^2-",-2, 4, { ELEM_C, ELEM_O, ELEM_O, ELEM_O } },
+    { "SO4^2-",-2, 5, { ELEM_S, ELEM_O, ELEM_O, ELEM_O, ELEM_O } },
+    { "HNO3",   0, 5, { ELEM_N, ELEM_O, ELEM_O, ELEM_O, ELEM_H } },
+    { "C2H6",   0, 8, { ELEM_C, ELEM_C, ELEM_H, ELEM_H, ELEM_H, ELEM_H, ELEM_H, ELEM_H } },
+    { "C2H4O2", 0, 8, { ELEM_C, ELEM_C, ELEM_O, ELEM_O, ELEM_H, ELEM_H, ELEM_H, ELEM_H } },
+};
+
+/* Largest per-atom pixel difference between the replica and the fixed-point tree layout, or -1. */
+static int tree_dpx(const Molecule *mol, const LewisStructure *ls)
+{
+    int ax[MAX_ATOMS];
+    int ay[MAX_ATOMS];
+    AtomLayout lay;
+    unsigned long divs = old_divs;
+    FxOpCounts ops = fx_ops;
+    bool old_ok = old_tree(mol, ls, ax, ay);
+    bool new_ok = layout_tree_from_central(mol, ls, &lay);
+    old_divs = divs;
+    fx_ops = ops;
+    if (!old_ok || !new_ok) return -1;
+
+    int max_dpx = 0;
+    for (uint8_t i = 0; i < mol->num_atoms; i++) {
+        int d = abs(ax[i] - lay.x[i]);
+        if (abs(ay[i] - lay.y[i]) > d) d = abs(ay[i] - lay.y[i]);
+        if (d > max_dpx) max_dpx = d;
+    }
+    return max_dpx;
+}
+
+int main(void)
+{
+    unsigned long total_old = 0;
+    unsigned long total_frame_recips = 0;
+    unsigned long total_layout_recips = 0;
+    unsigned long total_layout_muls = 0;
+    unsigned long total_forms = 0;
+
+    printf("%-8s %5s %11s %10s %8s %10s %8s %9s\n",
+           "molecule", "forms", "old div/frm", "recip/frm", "mul/frm", "recip/lay", "mul/lay", "tree dpx");
+
+    for (size_t s = 0; s < sizeof(samples) / sizeof(samples[0]); s++) {
+        Molecule mol;
+        molecule_reset(&mol);
+        mol.charge = samples[s].charge;
+        mol.num_atoms = samples[s].count;
+        for (uint8_t i = 0; i < samples[s].count; i++) mol.atoms[i].elem = samples[s].atoms[i];
+        generate_resonance(&mol);
+        if (mol.num_res == 0) {
+            printf("%-8s %5s\n", samples[s].name, "n/a");
+            continue;
+        }
+
+        FxOpCounts frame_ops = { 0, 0 };
+        FxOpCounts layout_ops = { 0, 0 };
+        old_divs = 0;
+        int max_dpx = -1;
+
+        for (uint8_t r = 0; r < mol.num_res; r++) {
+            int ax[MAX_ATOMS];
+            int ay[MAX_ATOMS];
+            AtomLayout lay;
+            LewisStructure ls;
+            DisplayList dl;
+            molecule_form(&mol, r, &ls);
+            old_frame(&mol, &ls, ax, ay);
+
+            memset(&fx_ops, 0, sizeof(fx_ops));
+            layout_structure(&mol, &ls, &lay, lewis_scratch());
+            layout_ops.recips += fx_ops.recips;
+            layout_ops.muls += fx_ops.muls;
+
+            memset(&fx_ops, 0, sizeof(fx_ops));
+            display_list_build(&mol, &ls, &mol.layout[r], &dl);
+            frame_ops.recips += fx_ops.recips;
+            frame_ops.muls += fx_ops.muls;
+
+            int d = tree_dpx(&mol, &ls);
+            if (d > max_dpx) max_dpx = d;
+        }
+
+        printf("%-8s %5u %11.1f %10.1f %8.1f %10.1f %8.1f ",
+               samples[s].name,
+               mol.num_res,
+               (double)old_divs / mol.num_res,
+               (double)frame_ops.recips / mol.num_res,
+               (double)frame_ops.muls / mol.num_res,
+               (double)layout_ops.recips / mol.num_res,
+               (double)layout_ops.muls / mol.num_res);
+        if (max_dpx < 0) printf("%9s\n", "-");
+        else printf("%9d\n", max_dpx);
+        total_old += old_divs;
+        total_frame_recips += frame_ops.recips;
+        total_layout_recips += layout_ops.recips;
+        total_layout_muls += layout_ops.muls;
+        total_forms += mol.num_res;
+    }
+
+    double n = total_forms ? (double)total_forms : 1.0;
+    printf("\ndivides per frame: %.1f hardware in the former draw path, %.1f reciprocal in display_list_build\n",
+           (double)total_old / n, (double)total_frame_recips / n);
+    printf("once per solve and form: %.1f reciprocal divides, %.1f multiplies in layout_structure\n",
+           (double)total_layout_recips / n, (double)total_layout_muls / n);
+    return 0;
+}
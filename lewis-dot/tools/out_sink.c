@@ -0,0 +1,118 @@
+#include "out_sink.h"
+
+#include <string.h>
+
+void out_sink_init(OutSink *s, char *buf, size_t cap, OutFlushFn flush, void *ctx)
+{
+    s->buf = buf;
+    s->cap = cap;
+    s->len = 0;
+    s->flushed = 0;
+    s->flush = flush;
+    s->ctx = ctx;
+    s->failed = false;
+}
+
+void out_sink_init_buffer(OutSink *s, char *buf, size_t cap)
+{
+    out_sink_init(s, buf, cap, NULL, NULL);
+}
+
+static bool file_flush(void *ctx, const char *data, size_t len)
+{
+    return fwrite(data, 1, len, (FILE *)ctx) == len;
+}
+
+void out_sink_init_file(OutSink *s, FILE *f, char *buf, size_t cap)
+{
+    out_sink_init(s, buf, cap, file_flush, f);
+}
+
+static bool drain(OutSink *s)
+{
+    if (s->flush == NULL || !s->flush(s->ctx, s->buf, s->len)) {
+        s->failed = true;
+        return false;
+    }
+    s->flushed += s->len;
+    s->len = 0;
+    return true;
+}
+
+void out_sink_write(OutSink *s, const char *data, size_t n)
+{
+    if (s->failed) return;
+
+    while (n > s->cap - s->len) {
+        size_t room = s->cap - s->len;
+        memcpy(s->buf + s->len, data, room);
+        s->len += room;
+        data += room;
+        n -= room;
+        if (!drain(s)) return;
+    }
+    memcpy(s->buf + s->len, data, n);
+    s->len += n;
+}
+
+void out_sink_puts(OutSink *s, const char *str)
+{
+    out_sink_write(s, str, strlen(str));
+}
+
+void out_sink_putc(OutSink *s, char c)
+{
+    if (s->len < s->cap) {
+        if (!s->failed) s->buf[s->len++] = c;
+        return;
+    }
+    out_sink_write(s, &c, 1);
+}
+
+void out_sink_put_fixed(OutSink *s, int32_t v, uint8_t decimals, uint8_t width)
+{
+    char tmp[16];
+    uint8_t pos = sizeof(tmp);
+    bool negative = v < 0;
+    uint32_t mag = negative ? (uint32_t)0 - (uint32_t)v : (uint32_t)v;
+
+    /* Digits from the right; the point goes in after `decimals` of them. */
+    for (uint8_t d = 0; d < decimals; d++) {
+        tmp[--pos] = (char)('0' + mag % 10u);
+        mag /= 10u;
+    }
+    if (decimals > 0) tmp[--pos] = '.';
+    do {
+        tmp[--pos] = (char)('0' + mag % 10u);
+        mag /= 10u;
+    } while (mag != 0);
+    if (negative) tmp[--pos] = '-';
+
+    for (uint8_t used = (uint8_t)(sizeof(tmp) - pos); used < width; used++) out_sink_putc(s, ' ');
+    out_sink_write(s, tmp + pos, sizeof(tmp) - pos);
+}
+
+void out_sink_put_int(OutSink *s, int32_t v, uint8_t width)
+{
+    out_sink_put_fixed(s, v, 0, width);
+}
+
+bool out_sink_flush(OutSink *s)
+{
+    if (s->failed) return false;
+    if (s->len == 0 || s->flush == NULL) return true;
+    return drain(s);
+}
+
+OutMark out_sink_mark(const OutSink *s)
+{
+    OutMark m = { s->len, s->flushed };
+    return m;
+}
+
+bool out_sink_rollback(OutSink *s, OutMark m)
+{
+    if (s->flushed != m.flushed || s->len < m.len) return false;
+    s->len = m.len;
+    return true;
+}
@@ -0,0 +1,59 @@
+#ifndef OUT_SINK_H
+#define OUT_SINK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * Byte sink for the text exporters. Output collects in a caller-supplied
+ * buffer; when it fills, the flush callback (if any) drains it, otherwise
+ * the sink fails. Failure is sticky, like LewisBitWriter.overflow, so
+ * writers check it once per record. Nothing here allocates.
+ */
+typedef bool (*OutFlushFn)(void *ctx, const char *data, size_t len);
+
+typedef struct {
+    char *buf;
+    size_t cap;
+    size_t len;       /* bytes waiting in buf */
+    size_t flushed;   /* bytes handed to flush so far */
+    OutFlushFn flush; /* NULL: buffer only */
+    void *ctx;
+    bool failed;
+} OutSink;
+
+/* Position to roll a partial record back to. */
+typedef struct {
+    size_t len;
+    size_t flushed;
+} OutMark;
+
+void out_sink_init(OutSink *s, char *buf, size_t cap, OutFlushFn flush, void *ctx);
+void out_sink_init_buffer(OutSink *s, char *buf, size_t cap);
+void out_sink_init_file(OutSink *s, FILE *f, char *buf, size_t cap);
+
+void out_sink_write(OutSink *s, const char *data, size_t n);
+void out_sink_puts(OutSink *s, const char *str);
+void out_sink_putc(OutSink *s, char c);
+
+/* Decimal v right-aligned in width columns (wider values are not cut). */
+void out_sink_put_int(OutSink *s, int32_t v, uint8_t width);
+
+/* v / 10^decimals with exactly that many decimals, right-aligned. */
+void out_sink_put_fixed(OutSink *s, int32_t v, uint8_t decimals, uint8_t width);
+
+/* Drain the buffer through flush. False if the sink has failed. */
+bool out_sink_flush(OutSink *s);
+
+OutMark out_sink_mark(const OutSink *s);
+
+/*
+ * Drop everything written since m, so a buffer never ends in half a
+ * record. False if part of it was already flushed. The failure flag is
+ * left as it is.
+ */
+bool out_sink_rollback(OutSink *s, OutMark m);
+
+#endif
@@ -0,0 +1,172 @@
+#include "result_store.h"
+
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "../src/lewis_engine.h"
+
+static uint32_t rd16(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+}
+
+static uint32_t rd32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+uint32_t result_store_hash(const uint8_t key[STORE_KEY_BYTES], uint32_t seed)
+{
+    /* FNV-1a with a seeded basis and a final avalanche. */
+    uint32_t h = 2166136261u ^ (seed * 0x9E3779B9u);
+    for (uint32_t i = 0; i < STORE_KEY_BYTES; i++) {
+        h ^= key[i];
+        h *= 16777619u;
+    }
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 12;
+    return h;
+}
+
+bool result_store_attach(ResultStore *store, const void *data, size_t size)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    memset(store, 0, sizeof(*store));
+    if (p == NULL || size < STORE_HEADER_BYTES) return false;
+    if (rd32(p) != STORE_MAGIC || rd32(p + 4) != STORE_VERSION) return false;
+
+    uint32_t count = rd32(p + 8);
+    uint32_t buckets = rd32(p + 12);
+    uint32_t slots = rd32(p + 16);
+    uint32_t seeds_off = rd32(p + 20);
+    uint32_t slots_off = rd32(p + 24);
+    uint32_t records_off = rd32(p + 28);
+    if (buckets == 0 || slots == 0 || count > slots) return false;
+    if (seeds_off < STORE_HEADER_BYTES || (uint64_t)seeds_off + (uint64_t)buckets * 2u > slots_off) return false;
+    if ((uint64_t)slots_off + (uint64_t)slots * STORE_SLOT_BYTES > records_off || records_off > size) return false;
+
+    store->base = p;
+    store->size = size;
+    store->count = count;
+    store->buckets = buckets;
+    store->slots = slots;
+    store->seeds = p + seeds_off;
+    store->slot_table = p + slots_off;
+    store->records = p + records_off;
+    store->records_len = (uint32_t)(size - records_off);
+    return true;
+}
+
+bool result_store_open(ResultStore *store, const char *path)
+{
+    memset(store, 0, sizeof(*store));
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size;
+    HANDLE mapping = NULL;
+    const void *view = NULL;
+    if (GetFileSizeEx(file, &size)) mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (mapping == NULL) return false;
+    view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == NULL || !result_store_attach(store, view, (size_t)size.QuadPart)) {
+        if (view != NULL) UnmapViewOfFile(view);
+        CloseHandle(mapping);
+        return false;
+    }
+    store->map = mapping;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    void *view = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (view == MAP_FAILED) return false;
+    if (!result_store_attach(store, view, (size_t)st.st_size)) {
+        munmap(view, (size_t)st.st_size);
+        return false;
+    }
+    store->map = view;
+#endif
+    return true;
+}
+
+void result_store_close(ResultStore *store)
+{
+    if (store->map != NULL) {
+#ifdef _WIN32
+        UnmapViewOfFile(store->base);
+        CloseHandle((HANDLE)store->map);
+#else
+        munmap((void *)store->base, store->size);
+#endif
+    }
+    memset(store, 0, sizeof(*store));
+}
+
+const uint8_t *result_store_find(const ResultStore *store, const Molecule *mol, size_t *len)
+{
+    if (store->base == NULL || mol->num_atoms == 0 || mol->num_atoms > MAX_ATOMS) return NULL;
+
+    uint8_t key[STORE_KEY_BYTES] = { 0 };
+    lewis_pack_key(mol, key);
+
+    uint32_t bucket = result_store_hash(key, 0) % store->buckets;
+    uint32_t seed = rd16(store->seeds + (size_t)bucket * 2u);
+    const uint8_t *slot = store->slot_table + (size_t)(result_store_hash(key, seed) % store->slots) * STORE_SLOT_BYTES;
+
+    uint32_t offset = rd32(slot + STORE_KEY_BYTES);
+    uint32_t length = rd32(slot + STORE_KEY_BYTES + 4);
+    if (length == 0 || memcmp(slot, key, STORE_KEY_BYTES) != 0) return NULL;
+    if (offset > store->records_len || length > store->records_len - offset) return NULL;
+
+    if (len != NULL) *len = length;
+    return store->records + offset;
+}
+
+bool result_store_lookup(const ResultStore *store, Molecule *mol)
+{
+    size_t len = 0;
+    const uint8_t *record = result_store_find(store, mol, &len);
+    if (record == NULL) return false;
+
+    LewisBitReader r;
+    lewis_bits_reader_init(&r, record, len);
+    if (!lewis_pack_read_forms(&r, mol)) return false;
+
+    const uint8_t *p = record + (r.bitpos >> 3);
+    if (len - (r.bitpos >> 3) != (size_t)mol->num_res * mol->num_atoms * STORE_LAYOUT_BYTES) return false;
+    for (uint8_t f = 0; f < mol->num_res; f++) {
+        AtomLayout *lay = &mol->layout[f];
+        for (uint8_t i = 0; i < mol->num_atoms; i++) {
+            lay->x[i] = (int16_t)rd16(p);
+            lay->y[i] = (int16_t)rd16(p + 2);
+            lay->lp_slots[i] = p[4];
+            p += STORE_LAYOUT_BYTES;
+        }
+    }
+    return true;
+}
+
+bool result_store_solve(const ResultStore *store, Molecule *mol)
+{
+    Molecule query = *mol;
+    if (result_store_lookup(store, mol)) return true;
+
+    *mol = query;
+    generate_resonance(mol);
+    return false;
+}
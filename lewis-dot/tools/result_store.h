@@ -0,0 +1,74 @@
+#ifndef RESULT_STORE_H
+#define RESULT_STORE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../src/lewis_model.h"
+#include "../src/lewis_pack.h"
+
+/*
+ * Immutable precomputed result file, built by store_build.c and mapped
+ * read-only by result_store_open(). All fields are little-endian and
+ * 4-byte aligned; nothing is parsed or copied at open time.
+ *
+ *   header   STORE_HEADER_BYTES (magic, version, counts, section offsets)
+ *   seeds    uint16 per bucket    second-level hash seed
+ *   slots    STORE_SLOT_BYTES per slot: key[STORE_KEY_BYTES], uint32
+ *            record offset, uint32 record length (0 = empty slot)
+ *   records  back to back; each is a lewis_pack record followed by its
+ *            layouts, STORE_LAYOUT_BYTES per atom per form (int16 x,
+ *            int16 y, lp_slots), so a hit skips layout_molecule()
+ *
+ * The index is a hash-and-displace perfect hash over lewis_pack_key():
+ * bucket = hash(key, 0) % buckets, slot = hash(key, seeds[bucket]) % slots.
+ * Every stored key lands in its own slot, so a lookup is two hashes, one
+ * key compare, one record decode and one layout copy.
+ */
+#define STORE_MAGIC         0x5344444Cu /* "LDDS" */
+#define STORE_VERSION       1u
+#define STORE_HEADER_BYTES  32u
+#define STORE_KEY_BYTES     16u
+#define STORE_SLOT_BYTES    (STORE_KEY_BYTES + 8u)
+#define STORE_LAYOUT_BYTES  5u
+
+#if LEWIS_PACK_KEY_BYTES > STORE_KEY_BYTES
+#error "composition key does not fit a store slot"
+#endif
+
+typedef struct {
+    const uint8_t *base;
+    size_t size;
+    uint32_t count;     /* stored results */
+    uint32_t buckets;
+    uint32_t slots;
+    const uint8_t *seeds;
+    const uint8_t *slot_table;
+    const uint8_t *records;
+    uint32_t records_len;
+    void *map;          /* platform mapping handle, NULL when attached */
+} ResultStore;
+
+uint32_t result_store_hash(const uint8_t key[STORE_KEY_BYTES], uint32_t seed);
+
+/* Map a store file read-only. False if it cannot be opened or is malformed. */
+bool result_store_open(ResultStore *store, const char *path);
+void result_store_close(ResultStore *store);
+
+/* Use an image already in memory (validated the same way as a file). */
+bool result_store_attach(ResultStore *store, const void *data, size_t size);
+
+/* Packed record for mol's composition and charge, or NULL on a miss. */
+const uint8_t *result_store_find(const ResultStore *store, const Molecule *mol, size_t *len);
+
+/*
+ * Replace mol with the stored result for its composition and charge. Atoms
+ * come back in canonical (ascending element) order. False on a miss.
+ */
+bool result_store_lookup(const ResultStore *store, Molecule *mol);
+
+/* Stored result when present, else generate_resonance(). True on a hit. */
+bool result_store_solve(const ResultStore *store, Molecule *mol);
+
+#endif
@@ -0,0 +1,27 @@
+$ErrorActionPreference = "Stop"
+
+$toolDir = Split-Path -Parent $MyInvocation.MyCommand.Path
+$srcDir = Join-Path $toolDir "..\src"
+$outExe = Join-Path $toolDir "op_count.exe"
+
+$sources = @(
+    (Join-Path $srcDir "lewis_model.c"),
+    (Join-Path $srcDir "arena.c"),
+    (Join-Path $srcDir "fixed_math.c"),
+    (Join-Path $srcDir "layout.c"),
+    (Join-Path $srcDir "display_list.c"),
+    (Join-Path $srcDir "lewis_engine.c"),
+    (Join-Path $toolDir "op_count.c")
+)
+
+if (Get-Command clang -ErrorAction SilentlyContinue) {
+    & clang -std=c11 -Wall -Wextra -O2 -DLEWIS_OP_COUNT -I $srcDir @sources -o $outExe
+} elseif (Get-Command gcc -ErrorAction SilentlyContinue) {
+    & gcc -std=c11 -Wall -Wextra -O2 -DLEWIS_OP_COUNT -I $srcDir @sources -o $outExe
+} elseif (Get-Command zig -ErrorAction SilentlyContinue) {
+    & zig cc -std=c11 -Wall -Wextra -O2 -DLEWIS_OP_COUNT -I $srcDir @sources -o $outExe
+} else {
+    Write-Error "No host C compiler found (clang/gcc/zig cc)."
+}
+
+& $outExe
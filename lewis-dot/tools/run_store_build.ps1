@@ -0,0 +1,38 @@
+param(
+    [Parameter(ValueFromRemainingArguments = $true)]
+    [string[]]$BuildArgs
+)
+
+$ErrorActionPreference = "Stop"
+
+$toolDir = Split-Path -Parent $MyInvocation.MyCommand.Path
+$srcDir = Join-Path $toolDir "..\src"
+$outExe = Join-Path $toolDir "store_build.exe"
+
+$sources = @(
+    (Join-Path $srcDir "lewis_model.c"),
+    (Join-Path $srcDir "arena.c"),
+    (Join-Path $srcDir "fixed_math.c"),
+    (Join-Path $srcDir "layout.c"),
+    (Join-Path $srcDir "lewis_engine.c"),
+    (Join-Path $srcDir "lewis_pack.c"),
+    (Join-Path $toolDir "result_store.c"),
+    (Join-Path $toolDir "corpus.c"),
+    (Join-Path $toolDir "store_build.c")
+)
+
+if (Get-Command clang -ErrorAction SilentlyContinue) {
+    & clang -std=c11 -Wall -Wextra -O2 -I $srcDir @sources -o $outExe
+} elseif (Get-Command gcc -ErrorAction SilentlyContinue) {
+    & gcc -std=c11 -Wall -Wextra -O2 -I $srcDir @sources -o $outExe
+} elseif (Get-Command zig -ErrorAction SilentlyContinue) {
+    & zig cc -std=c11 -Wall -Wextra -O2 -I $srcDir @sources -o $outExe
+} else {
+    Write-Error "No host C compiler found (clang/gcc/zig cc)."
+}
+
+if (-not $BuildArgs) {
+    $BuildArgs = @((Join-Path $toolDir "layout_corpus.txt"), (Join-Path $toolDir "results.lds"))
+}
+
+& $outExe @BuildArgs
@@ -0,0 +1,112 @@
+#include "sdf_writer.h"
+
+static void put_title(OutSink *out, const Molecule *mol)
+{
+    char formula[MOLECULE_FORMULA_MAX];
+    out_sink_write(out, formula, molecule_formula(mol, formula));
+    if (mol->charge != 0) {
+        out_sink_putc(out, ' ');
+        out_sink_put_int(out, mol->charge, 0);
+    }
+    out_sink_putc(out, '\n');
+}
+
+static int32_t angstrom_e4(int pixels)
+{
+    int32_t scaled = (int32_t)pixels * SDF_BOND_ANGSTROM_E4;
+    scaled += (scaled >= 0) ? BOND_LEN / 2 : -(BOND_LEN / 2);
+    return scaled / BOND_LEN;
+}
+
+/* Atom-block charge code: 3/2/1 for +1/+2/+3, 5/6/7 for -1/-2/-3. */
+static int32_t charge_code(int8_t fc)
+{
+    if (fc == 0 || fc > 3 || fc < -3) return 0;
+    return 4 - fc;
+}
+
+bool sdf_write_form(OutSink *out, const Molecule *mol, uint8_t form)
+{
+    if (form >= mol->num_res) return false;
+
+    LewisStructure unpacked;
+    molecule_form(mol, form, &unpacked);
+    const LewisStructure *ls = &unpacked;
+    const AtomLayout *lay = &mol->layout[form];
+    OutMark start = out_sink_mark(out);
+
+    put_title(out, mol);
+    out_sink_puts(out, "  LEWISDOT          2D\n");
+    out_sink_puts(out, "resonance form ");
+    out_sink_put_int(out, form + 1, 0);
+    out_sink_puts(out, " of ");
+    out_sink_put_int(out, mol->num_res, 0);
+    out_sink_putc(out, '\n');
+
+    out_sink_put_int(out, mol->num_atoms, 3);
+    out_sink_put_int(out, ls->num_bonds, 3);
+    out_sink_puts(out, "  0  0  0  0  0  0  0  0999 V2000\n");
+
+    uint8_t charged = 0;
+    for (uint8_t i = 0; i < mol->num_atoms; i++) {
+        const char *sym = elements[mol->atoms[i].elem].symbol;
+        out_sink_put_fixed(out, angstrom_e4(lay->x[i] - LEWIS_CENTER_X), 4, 10);
+        out_sink_put_fixed(out, angstrom_e4(LEWIS_CENTER_Y - lay->y[i]), 4, 10);
+        out_sink_puts(out, "    0.0000 ");
+        out_sink_puts(out, sym);
+        out_sink_puts(out, sym[1] ? " " : "  ");
+        out_sink_puts(out, " 0");
+        out_sink_put_int(out, charge_code(ls->formal_charge[i]), 3);
+        out_sink_puts(out, "  0  0  0  0  0  0  0  0  0  0\n");
+        if (ls->formal_charge[i] != 0) charged++;
+    }
+
+    for (uint8_t b = 0; b < ls->num_bonds; b++) {
+        out_sink_put_int(out, ls->bonds[b].a + 1, 3);
+        out_sink_put_int(out, ls->bonds[b].b + 1, 3);
+        out_sink_put_int(out, ls->bonds[b].order, 3);
+        out_sink_puts(out, "  0\n");
+    }
+
+    /* M  CHG takes at most eight atoms per line and overrides the atom block. */
+    uint8_t atom = 0;
+    while (charged > 0) {
+        uint8_t line = charged > 8 ? 8 : charged;
+        out_sink_puts(out, "M  CHG");
+        out_sink_put_int(out, line, 3);
+        for (uint8_t k = 0; k < line; atom++) {
+            if (ls->formal_charge[atom] == 0) continue;
+            out_sink_put_int(out, atom + 1, 4);
+            out_sink_put_int(out, ls->formal_charge[atom], 4);
+            k++;
+        }
+        out_sink_putc(out, '\n');
+        charged = (uint8_t)(charged - line);
+    }
+    out_sink_puts(out, "M  END\n");
+
+    out_sink_puts(out, "> <RESONANCE_FORM>\n");
+    out_sink_put_int(out, form + 1, 0);
+    out_sink_puts(out, "\n\n> <LONE_PAIRS>\n");
+    for (uint8_t i = 0; i < mol->num_atoms; i++) {
+        if (i > 0) out_sink_putc(out, ' ');
+        out_sink_put_int(out, ls->lone_pairs[i], 0);
+    }
+    out_sink_puts(out, "\n\n$$$$\n");
+
+    if (out->failed) {
+        out_sink_rollback(out, start);
+        return false;
+    }
+    return true;
+}
+
+bool sdf_write_molecule(OutSink *out, const Molecule *mol)
+{
+    if (mol->num_res == 0) return false;
+
+    for (uint8_t r = 0; r < mol->num_res; r++) {
+        if (!sdf_write_form(out, mol, r)) return false;
+    }
+    return true;
+}
@@ -0,0 +1,29 @@
+#ifndef SDF_WRITER_H
+#define SDF_WRITER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../src/lewis_model.h"
+#include "out_sink.h"
+
+/*
+ * MDL V2000 molfile / SD-file records for generated structures. Each
+ * record holds one resonance form: atoms with layout coordinates (BOND_LEN
+ * pixels = SDF_BOND_ANGSTROM_E4 / 10000 A, y up, z = 0), bonds with their
+ * orders, formal charges in the atom block and as M  CHG lines, and
+ * RESONANCE_FORM and LONE_PAIRS data items. The title line is the
+ * composition in corpus form ("SO4 -2").
+ */
+#define SDF_BOND_ANGSTROM_E4 15000
+
+/*
+ * Append the record for resonance form `form`. On failure the sink is
+ * rolled back to the record start when nothing of it was flushed.
+ */
+bool sdf_write_form(OutSink *out, const Molecule *mol, uint8_t form);
+
+/* One record per resonance form. False on a sink failure or no forms. */
+bool sdf_write_molecule(OutSink *out, const Molecule *mol);
+
+#endif
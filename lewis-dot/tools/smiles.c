@@ -0,0 +1,330 @@
+#include "smiles.h"
+
+#include <string.h>
+
+#define SMILES_MAX_RINGS 8
+#define SMILES_IMPLICIT_H 0xFF
+
+/* Bond symbols before they are resolved to orders. */
+enum {
+    SB_NONE = 0,
+    SB_SINGLE,
+    SB_DOUBLE,
+    SB_TRIPLE,
+    SB_AROMATIC
+};
+
+typedef struct {
+    Molecule *mol;
+    LewisStructure *ls;
+    uint8_t hcount[MAX_ATOMS];   /* bracket H count, or SMILES_IMPLICIT_H */
+    int8_t charge[MAX_ATOMS];
+    bool aromatic[MAX_ATOMS];
+    bool aromatic_bond[MAX_BONDS];
+    uint8_t ring_label[SMILES_MAX_RINGS];
+    uint8_t ring_atom[SMILES_MAX_RINGS];
+    uint8_t ring_bond[SMILES_MAX_RINGS];
+    uint8_t open_rings;
+} SmilesState;
+
+static int find_symbol(const char *sym, uint8_t len)
+{
+    for (uint8_t e = 0; e < NUM_ELEMENTS; e++) {
+        const char *s = elements[e].symbol;
+        if (strlen(s) == len && strncmp(s, sym, len) == 0) return e;
+    }
+    return -1;
+}
+
+/* Element of a (possibly lowercase aromatic) symbol of length len. */
+static int find_element(const char *p, uint8_t len, bool *aromatic)
+{
+    char sym[2];
+    *aromatic = (p[0] >= 'a' && p[0] <= 'z');
+    sym[0] = *aromatic ? (char)(p[0] - 'a' + 'A') : p[0];
+    if (len > 1) sym[1] = p[1];
+    return find_symbol(sym, len);
+}
+
+static bool add_atom(SmilesState *st, uint8_t elem, bool aromatic, uint8_t hcount, int8_t charge)
+{
+    Molecule *mol = st->mol;
+    if (mol->num_atoms >= MAX_ATOMS) return false;
+
+    uint8_t i = mol->num_atoms++;
+    mol->atoms[i].elem = elem;
+    st->aromatic[i] = aromatic;
+    st->hcount[i] = hcount;
+    st->charge[i] = charge;
+    return true;
+}
+
+static bool add_bond(SmilesState *st, uint8_t a, uint8_t b, uint8_t sym)
+{
+    LewisStructure *ls = st->ls;
+    if (ls->num_bonds >= MAX_BONDS || a == b) return false;
+    for (uint8_t k = 0; k < ls->num_bonds; k++) {
+        if ((ls->bonds[k].a == a && ls->bonds[k].b == b) || (ls->bonds[k].a == b && ls->bonds[k].b == a)) return false;
+    }
+
+    /* An unmarked bond between two aromatic atoms is aromatic. */
+    if (sym == SB_NONE) sym = (st->aromatic[a] && st->aromatic[b]) ? SB_AROMATIC : SB_SINGLE;
+
+    Bond *bond = &ls->bonds[ls->num_bonds];
+    bond->a = a;
+    bond->b = b;
+    bond->order = (sym == SB_DOUBLE) ? 2 : (sym == SB_TRIPLE) ? 3 : 1;
+    st->aromatic_bond[ls->num_bonds] = (sym == SB_AROMATIC);
+    ls->num_bonds++;
+    return true;
+}
+
+/* "[...]" atom starting after '['. Returns the position after ']' or NULL. */
+static const char *parse_bracket(SmilesState *st, const char *p)
+{
+    while (*p >= '0' && *p <= '9') p++;  /* isotope */
+
+    uint8_t len = 1;
+    bool aromatic = false;
+    int elem = -1;
+    if (p[1] >= 'a' && p[1] <= 'z') {
+        elem = find_element(p, 2, &aromatic);
+        if (elem >= 0) len = 2;
+    }
+    if (elem < 0) elem = find_element(p, 1, &aromatic);
+    if (elem < 0) return NULL;
+    p += len;
+
+    while (*p == '@') p++;  /* chirality */
+
+    uint8_t hcount = 0;
+    if (*p == 'H') {
+        p++;
+        hcount = 1;
+        if (*p >= '0' && *p <= '9') hcount = (uint8_t)(*p++ - '0');
+    }
+
+    int charge = 0;
+    while (*p == '+' || *p == '-') {
+        int sign = (*p == '+') ? 1 : -1;
+        p++;
+        if (*p >= '1' && *p <= '9') charge += sign * (*p++ - '0');
+        else charge += sign;
+    }
+    if (charge < -8 || charge > 7) return NULL;
+
+    if (*p == ':') {  /* atom class */
+        p++;
+        while (*p >= '0' && *p <= '9') p++;
+    }
+    if (*p != ']') return NULL;
+
+    if (!add_atom(st, (uint8_t)elem, aromatic, hcount, (int8_t)charge)) return NULL;
+    return p + 1;
+}
+
+/* Organic-subset atom outside brackets. Returns the position after it or NULL. */
+static const char *parse_organic(SmilesState *st, const char *p)
+{
+    static const char organic[] = "BCNOPSFIbcnops";
+    bool aromatic = false;
+    int elem = -1;
+    uint8_t len = 1;
+
+    if ((p[0] == 'C' && p[1] == 'l') || (p[0] == 'B' && p[1] == 'r')) {
+        len = 2;
+        elem = find_element(p, 2, &aromatic);
+    } else if (strchr(organic, *p) != NULL) {
+        elem = find_element(p, 1, &aromatic);
+    }
+    if (elem < 0) return NULL;
+
+    if (!add_atom(st, (uint8_t)elem, aromatic, SMILES_IMPLICIT_H, 0)) return NULL;
+    return p + len;
+}
+
+static bool ring_closure(SmilesState *st, uint8_t label, uint8_t atom, uint8_t sym)
+{
+    for (uint8_t k = 0; k < st->open_rings; k++) {
+        if (st->ring_label[k] != label) continue;
+
+        /* Either end may carry the bond symbol; they must not disagree. */
+        uint8_t open_sym = st->ring_bond[k];
+        if (sym != SB_NONE && open_sym != SB_NONE && sym != open_sym) return false;
+        if (!add_bond(st, st->ring_atom[k], atom, sym != SB_NONE ? sym : open_sym)) return false;
+
+        st->open_rings--;
+        st->ring_label[k] = st->ring_label[st->open_rings];
+        st->ring_atom[k] = st->ring_atom[st->open_rings];
+        st->ring_bond[k] = st->ring_bond[st->open_rings];
+        return true;
+    }
+
+    if (st->open_rings >= SMILES_MAX_RINGS) return false;
+    st->ring_label[st->open_rings] = label;
+    st->ring_atom[st->open_rings] = atom;
+    st->ring_bond[st->open_rings] = sym;
+    st->open_rings++;
+    return true;
+}
+
+static int bond_sum(const LewisStructure *ls, uint8_t atom)
+{
+    int sum = 0;
+    for (uint8_t b = 0; b < ls->num_bonds; b++) {
+        if (ls->bonds[b].a == atom || ls->bonds[b].b == atom) sum += ls->bonds[b].order;
+    }
+    return sum;
+}
+
+/*
+ * Usual bonding capacity from the isoelectronic main-group column
+ * (N+ -> 4, C- -> 3, O+ -> 3, B- -> 4). Period 3+ atoms of groups 15-17
+ * step up by two (P 3/5, S 2/4/6) to cover the bonds already drawn.
+ */
+static int default_valence(uint8_t elem, int8_t charge, int bonds)
+{
+    const Element *e = &elements[elem];
+    int electrons = ((e->group <= 2) ? e->group : e->group - 10) - charge;
+    int base = (electrons <= 4) ? electrons : 8 - electrons;
+    if (base < 0) base = 0;
+
+    if (e->period >= 3 && e->group >= 15) {
+        while (base < bonds && base + 2 <= 7) base += 2;
+    }
+    return base;
+}
+
+/* Does aromatic atom i still need a double bond from the aromatic system? */
+static bool needs_double(const SmilesState *st, uint8_t i)
+{
+    uint8_t h = (st->hcount[i] == SMILES_IMPLICIT_H) ? 0 : st->hcount[i];
+    int used = bond_sum(st->ls, i) + h;
+    int target = default_valence(st->mol->atoms[i].elem, st->charge[i], 0);
+
+    /* Implicit hydrogens are added afterwards and only fill what is left. */
+    return target - used >= 1;
+}
+
+/* Backtracking perfect matching over aromatic bonds; n <= MAX_ATOMS. */
+static bool kekule_match(SmilesState *st, uint16_t pending)
+{
+    if (pending == 0) return true;
+
+    uint8_t i = 0;
+    while (!(pending & (1u << i))) i++;
+
+    LewisStructure *ls = st->ls;
+    for (uint8_t b = 0; b < ls->num_bonds; b++) {
+        if (!st->aromatic_bond[b] || ls->bonds[b].order != 1) continue;
+        uint8_t j;
+        if (ls->bonds[b].a == i) j = ls->bonds[b].b;
+        else if (ls->bonds[b].b == i) j = ls->bonds[b].a;
+        else continue;
+        if (!(pending & (1u << j))) continue;
+
+        ls->bonds[b].order = 2;
+        if (kekule_match(st, (uint16_t)(pending & ~((1u << i) | (1u << j))))) return true;
+        ls->bonds[b].order = 1;
+    }
+    return false;
+}
+
+static bool kekulize(SmilesState *st)
+{
+    uint16_t pending = 0;
+    for (uint8_t i = 0; i < st->mol->num_atoms; i++) {
+        if (st->aromatic[i] && needs_double(st, i)) pending |= (uint16_t)(1u << i);
+    }
+    return kekule_match(st, pending);
+}
+
+/* Append hydrogens as atoms bonded to their heavy atoms. */
+static bool add_hydrogens(SmilesState *st)
+{
+    uint8_t heavy = st->mol->num_atoms;
+    for (uint8_t i = 0; i < heavy; i++) {
+        int h = st->hcount[i];
+        if (st->hcount[i] == SMILES_IMPLICIT_H) {
+            int bonds = bond_sum(st->ls, i);
+            h = default_valence(st->mol->atoms[i].elem, 0, bonds) - bonds;
+            if (h < 0) h = 0;
+        }
+
+        while (h-- > 0) {
+            uint8_t hi = st->mol->num_atoms;
+            if (!add_atom(st, ELEM_H, false, 0, 0)) return false;
+            if (!add_bond(st, i, hi, SB_SINGLE)) return false;
+        }
+    }
+    return true;
+}
+
+bool smiles_parse(const char *text, Molecule *mol, LewisStructure *skeleton)
+{
+    SmilesState st;
+    memset(&st, 0, sizeof(st));
+    st.mol = mol;
+    st.ls = skeleton;
+    molecule_reset(mol);
+    memset(skeleton, 0, sizeof(*skeleton));
+
+    uint8_t branch[MAX_ATOMS];
+    uint8_t depth = 0;
+    int prev = -1;
+    uint8_t sym = SB_NONE;
+    const char *p = text;
+
+    while (*p != '\0') {
+        char c = *p;
+        if (c == '-' || c == '/' || c == '\\') {
+            sym = SB_SINGLE;
+            p++;
+        } else if (c == '=') {
+            sym = SB_DOUBLE;
+            p++;
+        } else if (c == '#') {
+            sym = SB_TRIPLE;
+            p++;
+        } else if (c == ':') {
+            sym = SB_AROMATIC;
+            p++;
+        } else if (c == '(') {
+            if (prev < 0 || depth >= MAX_ATOMS || sym != SB_NONE) return false;
+            branch[depth++] = (uint8_t)prev;
+            p++;
+        } else if (c == ')') {
+            if (depth == 0 || sym != SB_NONE) return false;
+            prev = branch[--depth];
+            p++;
+        } else if ((c >= '0' && c <= '9') || c == '%') {
+            uint8_t label;
+            if (c == '%') {
+                if (!(p[1] >= '0' && p[1] <= '9' && p[2] >= '0' && p[2] <= '9')) return false;
+                label = (uint8_t)((p[1] - '0') * 10 + (p[2] - '0'));
+                p += 3;
+            } else {
+                label = (uint8_t)(c - '0');
+                p++;
+            }
+            if (prev < 0 || !ring_closure(&st, label, (uint8_t)prev, sym)) return false;
+            sym = SB_NONE;
+        } else {
+            /* An atom; '.' and anything unknown fall through to failure. */
+            uint8_t atom = mol->num_atoms;
+            p = (c == '[') ? parse_bracket(&st, p + 1) : parse_organic(&st, p);
+            if (p == NULL) return false;
+            if (prev >= 0 && !add_bond(&st, (uint8_t)prev, atom, sym)) return false;
+            prev = atom;
+            sym = SB_NONE;
+        }
+    }
+
+    if (mol->num_atoms == 0 || depth != 0 || st.open_rings != 0 || sym != SB_NONE) return false;
+    if (!kekulize(&st) || !add_hydrogens(&st)) return false;
+
+    int charge = 0;
+    for (uint8_t i = 0; i < mol->num_atoms; i++) charge += st.charge[i];
+    mol->charge = (int8_t)charge;
+    return true;
+}
@@ -0,0 +1,22 @@
+#ifndef SMILES_H
+#define SMILES_H
+
+#include <stdbool.h>
+
+#include "../src/lewis_model.h"
+
+/*
+ * Parse a SMILES string into mol (atoms, overall charge) and skeleton
+ * (bonds with Kekule orders, no lone pairs yet) for
+ * generate_resonance_with_skeleton(). Supported: organic-subset and
+ * bracket atoms (isotope, chirality and atom class are ignored), charges,
+ * hydrogen counts, branches, ring closures (digits and %nn), bond symbols
+ * - = # : / \ and aromatic lowercase atoms, which are kekulized. Implicit
+ * hydrogens are added as atoms after the heavy atoms. Returns false on a
+ * syntax error, an unknown element, a disconnected input ('.'), an
+ * aromatic system without a Kekule form, or more than MAX_ATOMS atoms or
+ * MAX_BONDS bonds.
+ */
+bool smiles_parse(const char *text, Molecule *mol, LewisStructure *skeleton);
+
+#endif
@@ -0,0 +1,379 @@
+/*
+ * Host-side builder for the precomputed result store (result_store.h).
+ *
+ * Reads compositions from a corpus, canonicalizes each one (atoms sorted by
+ * element index), drops duplicates, solves it with generate_resonance() and
+ * packs the result with lewis_pack, followed by its layouts. Failed
+ * compositions are stored too, so a hit also answers "invalid, and why". A
+ * hash-and-displace perfect hash is then searched over the canonical keys
+ * and the image is written in one piece.
+ *
+ * The written file is then mapped with result_store_open() and every key is
+ * looked up and compared with a fresh solve; lookup and solve times are
+ * printed.
+ *
+ *   store_build corpus.txt out.lds [--random N [SEED]]
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/lewis_engine.h"
+#include "../src/lewis_model.h"
+#include "../src/lewis_pack.h"
+#include "corpus.h"
+#include "result_store.h"
+
+#define BUCKET_LOAD    4u  /* keys per first-level bucket */
+#define MAX_SEED       0xFFFFu
+
+typedef struct {
+    uint8_t key[STORE_KEY_BYTES];
+    uint32_t hash0;
+    uint32_t offset;
+    uint32_t length;
+} Entry;
+
+static Entry *entries;
+static size_t num_entries;
+static size_t cap_entries;
+static uint8_t *records;
+static size_t records_len;
+static size_t records_cap;
+
+/* ---- entries ---- */
+
+static void wr16(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void wr32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static void molecule_from_key(const uint8_t *key, Molecule *mol)
+{
+    molecule_reset(mol);
+    mol->num_atoms = key[0];
+    for (uint8_t i = 0; i < mol->num_atoms; i++) mol->atoms[i].elem = key[1 + i];
+    mol->charge = (int8_t)key[1 + mol->num_atoms];
+}
+
+/* Open-addressed set over canonical keys, sized on demand. */
+static uint32_t *seen;
+static size_t seen_cap;
+
+static bool seen_insert(size_t entry)
+{
+    if ((num_entries + 1) * 2 > seen_cap) {
+        size_t cap = seen_cap ? seen_cap * 2 : 1024;
+        uint32_t *grown = calloc(cap, sizeof(uint32_t));
+        if (grown == NULL) return false;
+        for (size_t i = 0; i < num_entries; i++) {
+            size_t s = entries[i].hash0 & (cap - 1);
+            while (grown[s] != 0) s = (s + 1) & (cap - 1);
+            grown[s] = (uint32_t)i + 1;
+        }
+        free(seen);
+        seen = grown;
+        seen_cap = cap;
+    }
+
+    size_t s = entries[entry].hash0 & (seen_cap - 1);
+    while (seen[s] != 0) {
+        if (memcmp(entries[seen[s] - 1].key, entries[entry].key, STORE_KEY_BYTES) == 0) return false;
+        s = (s + 1) & (seen_cap - 1);
+    }
+    seen[s] = (uint32_t)entry + 1;
+    return true;
+}
+
+static void add_molecule(const Molecule *input)
+{
+    if (num_entries == cap_entries) {
+        size_t cap = cap_entries ? cap_entries * 2 : 256;
+        Entry *grown = realloc(entries, cap * sizeof(Entry));
+        if (grown == NULL) return;
+        entries = grown;
+        cap_entries = cap;
+    }
+
+    Entry *e = &entries[num_entries];
+    memset(e->key, 0, sizeof(e->key));
+    lewis_pack_key(input, e->key);
+    e->hash0 = result_store_hash(e->key, 0);
+    if (!seen_insert(num_entries)) return;
+
+    size_t need = LEWIS_PACK_MAX_BYTES + (size_t)MAX_RESONANCE * MAX_ATOMS * STORE_LAYOUT_BYTES;
+    if (records_len + need > records_cap) {
+        size_t cap = records_cap ? records_cap * 2 : 4096;
+        uint8_t *grown = realloc(records, cap);
+        if (grown == NULL) return;
+        records = grown;
+        records_cap = cap;
+    }
+
+    Molecule mol;
+    molecule_from_key(e->key, &mol);
+    generate_resonance(&mol);
+    size_t len = lewis_pack(&mol, records + records_len, LEWIS_PACK_MAX_BYTES);
+    if (len == 0) return;
+
+    uint8_t *p = records + records_len + len;
+    for (uint8_t f = 0; f < mol.num_res; f++) {
+        for (uint8_t i = 0; i < mol.num_atoms; i++) {
+            wr16(p, (uint16_t)mol.layout[f].x[i]);
+            wr16(p + 2, (uint16_t)mol.layout[f].y[i]);
+            p[4] = mol.layout[f].lp_slots[i];
+            p += STORE_LAYOUT_BYTES;
+        }
+    }
+    len = (size_t)(p - (records + records_len));
+
+    e->offset = (uint32_t)records_len;
+    e->length = (uint32_t)len;
+    records_len += len;
+    num_entries++;
+}
+
+/* ---- perfect hash ---- */
+
+static uint32_t *bucket_start;  /* entries of bucket b: order[bucket_start[b] .. bucket_start[b + 1]) */
+static uint32_t *order;
+
+static int cmp_bucket_size(const void *pa, const void *pb)
+{
+    uint32_t a = *(const uint32_t *)pa;
+    uint32_t b = *(const uint32_t *)pb;
+    uint32_t sa = bucket_start[a + 1] - bucket_start[a];
+    uint32_t sb = bucket_start[b + 1] - bucket_start[b];
+    if (sa != sb) return sa < sb ? 1 : -1;
+    return a < b ? -1 : (a > b);
+}
+
+/* Fill seeds[] and slot_entry[] (entry index + 1, 0 = empty). False if a bucket finds no seed. */
+static bool build_index(uint32_t buckets, uint32_t slots, uint16_t *seeds, uint32_t *slot_entry)
+{
+    bucket_start = calloc(buckets + 1u, sizeof(uint32_t));
+    order = malloc((num_entries + 1) * sizeof(uint32_t));
+    uint32_t *by_size = malloc(buckets * sizeof(uint32_t));
+    uint32_t *fill = calloc(buckets, sizeof(uint32_t));
+    uint32_t *trial = malloc((num_entries + 1) * sizeof(uint32_t));
+    bool ok = bucket_start && order && by_size && fill && trial;
+
+    if (ok) {
+        for (size_t i = 0; i < num_entries; i++) bucket_start[entries[i].hash0 % buckets + 1]++;
+        for (uint32_t b = 0; b < buckets; b++) bucket_start[b + 1] += bucket_start[b];
+        for (size_t i = 0; i < num_entries; i++) {
+            uint32_t b = entries[i].hash0 % buckets;
+            order[bucket_start[b] + fill[b]++] = (uint32_t)i;
+        }
+        for (uint32_t b = 0; b < buckets; b++) by_size[b] = b;
+        qsort(by_size, buckets, sizeof(uint32_t), cmp_bucket_size);
+    }
+
+    /* Largest buckets first, while the table is still mostly empty. */
+    for (uint32_t k = 0; ok && k < buckets; k++) {
+        uint32_t b = by_size[k];
+        uint32_t first = bucket_start[b];
+        uint32_t n = bucket_start[b + 1] - first;
+        seeds[b] = 0;
+        if (n == 0) continue;
+
+        bool placed = false;
+        for (uint32_t seed = 1; seed <= MAX_SEED && !placed; seed++) {
+            placed = true;
+            for (uint32_t j = 0; j < n && placed; j++) {
+                trial[j] = result_store_hash(entries[order[first + j]].key, seed) % slots;
+                if (slot_entry[trial[j]] != 0) placed = false;
+                for (uint32_t q = 0; q < j && placed; q++) {
+                    if (trial[q] == trial[j]) placed = false;
+                }
+            }
+            if (placed) {
+                seeds[b] = (uint16_t)seed;
+                for (uint32_t j = 0; j < n; j++) slot_entry[trial[j]] = order[first + j] + 1;
+            }
+        }
+        if (!placed) ok = false;
+    }
+
+    free(bucket_start);
+    free(order);
+    free(by_size);
+    free(fill);
+    free(trial);
+    return ok;
+}
+
+/* ---- image ---- */
+
+static uint8_t *build_image(size_t *size_out)
+{
+    uint32_t buckets = (uint32_t)(num_entries / BUCKET_LOAD) + 1u;
+    uint32_t slots = (uint32_t)(num_entries + num_entries / 4) + 1u;
+    uint16_t *seeds = calloc(buckets, sizeof(uint16_t));
+    uint32_t *slot_entry = calloc(slots, sizeof(uint32_t));
+    uint8_t *image = NULL;
+
+    if (seeds != NULL && slot_entry != NULL && build_index(buckets, slots, seeds, slot_entry)) {
+        uint32_t seeds_off = STORE_HEADER_BYTES;
+        uint32_t slots_off = (seeds_off + buckets * 2u + 3u) & ~3u;
+        uint32_t records_off = slots_off + slots * STORE_SLOT_BYTES;
+        size_t size = (size_t)records_off + records_len;
+        image = calloc(size, 1);
+        if (image != NULL) {
+            wr32(image, STORE_MAGIC);
+            wr32(image + 4, STORE_VERSION);
+            wr32(image + 8, (uint32_t)num_entries);
+            wr32(image + 12, buckets);
+            wr32(image + 16, slots);
+            wr32(image + 20, seeds_off);
+            wr32(image + 24, slots_off);
+            wr32(image + 28, records_off);
+            for (uint32_t b = 0; b < buckets; b++) wr16(image + seeds_off + b * 2u, seeds[b]);
+            for (uint32_t s = 0; s < slots; s++) {
+                if (slot_entry[s] == 0) continue;
+                const Entry *e = &entries[slot_entry[s] - 1];
+                uint8_t *slot = image + slots_off + (size_t)s * STORE_SLOT_BYTES;
+                memcpy(slot, e->key, STORE_KEY_BYTES);
+                wr32(slot + STORE_KEY_BYTES, e->offset);
+                wr32(slot + STORE_KEY_BYTES + 4, e->length);
+            }
+            memcpy(image + records_off, records, records_len);
+            *size_out = size;
+        }
+    }
+
+    free(seeds);
+    free(slot_entry);
+    return image;
+}
+
+/* ---- driver ---- */
+
+static double now_nanos(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/* Every key must hit and decode to the same result as a fresh solve. */
+static bool verify(const ResultStore *store, double *lookup_ns, double *solve_ns)
+{
+    double lookup_total = 0.0;
+    double solve_total = 0.0;
+    for (size_t i = 0; i < num_entries; i++) {
+        Molecule stored;
+        Molecule fresh;
+        molecule_from_key(entries[i].key, &stored);
+        molecule_from_key(entries[i].key, &fresh);
+
+        double t0 = now_nanos();
+        bool hit = result_store_lookup(store, &stored);
+        double t1 = now_nanos();
+        generate_resonance(&fresh);
+        double t2 = now_nanos();
+        lookup_total += t1 - t0;
+        solve_total += t2 - t1;
+
+        if (!hit || stored.num_res != fresh.num_res || stored.invalid_reason != fresh.invalid_reason) return false;
+        if (fresh.num_res > 0 && memcmp(&stored.base, &fresh.base, sizeof(stored.base)) != 0) return false;
+        for (uint8_t f = 1; f < fresh.num_res; f++) {
+            const ResonanceDelta *ds = &stored.delta[f - 1], *df = &fresh.delta[f - 1];
+            if (ds->count != df->count || memcmp(ds->change, df->change, df->count) != 0) return false;
+        }
+        if (memcmp(stored.layout, fresh.layout, sizeof(AtomLayout) * fresh.num_res) != 0) return false;
+    }
+    *lookup_ns = num_entries ? lookup_total / (double)num_entries : 0.0;
+    *solve_ns = num_entries ? solve_total / (double)num_entries : 0.0;
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    const char *corpus = NULL;
+    const char *out = NULL;
+    unsigned long random_n = 0;
+
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "--random") == 0 && a + 1 < argc) {
+            random_n = strtoul(argv[++a], NULL, 10);
+            if (a + 1 < argc && argv[a + 1][0] != '-') corpus_random_seed((uint32_t)strtoul(argv[++a], NULL, 10));
+        } else if (corpus == NULL) {
+            corpus = argv[a];
+        } else {
+            out = argv[a];
+        }
+    }
+    if (corpus == NULL || out == NULL) {
+        fprintf(stderr, "usage: store_build corpus.txt out.lds [--random N [SEED]]\n");
+        return 1;
+    }
+
+    FILE *f = fopen(corpus, "r");
+    if (f == NULL) {
+        fprintf(stderr, "cannot open %s\n", corpus);
+        return 1;
+    }
+    char line[128];
+    Molecule mol;
+    while (corpus_next(f, line, sizeof(line), &mol)) {
+        add_molecule(&mol);
+    }
+    fclose(f);
+
+    for (unsigned long k = 0; k < random_n; k++) {
+        corpus_random_molecule(&mol);
+        if (mol.num_atoms > 0) add_molecule(&mol);
+    }
+
+    size_t size = 0;
+    uint8_t *image = build_image(&size);
+    if (image == NULL) {
+        fprintf(stderr, "perfect-hash search failed\n");
+        return 1;
+    }
+
+    FILE *o = fopen(out, "wb");
+    if (o == NULL || fwrite(image, 1, size, o) != size) {
+        fprintf(stderr, "cannot write %s\n", out);
+        if (o != NULL) fclose(o);
+        return 1;
+    }
+    fclose(o);
+
+    /* Check the file through the same mapping a service would use. */
+    ResultStore store;
+    double lookup_ns = 0.0;
+    double solve_ns = 0.0;
+    if (!result_store_open(&store, out) || !verify(&store, &lookup_ns, &solve_ns)) {
+        fprintf(stderr, "%s failed verification\n", out);
+        result_store_close(&store);
+        remove(out);
+        return 1;
+    }
+
+    printf("results %lu, slots %lu, buckets %lu\n",
+           (unsigned long)num_entries, (unsigned long)store.slots, (unsigned long)store.buckets);
+    printf("image %lu bytes (records %lu, %.1f bytes/result)\n",
+           (unsigned long)size, (unsigned long)records_len,
+           num_entries ? (double)records_len / (double)num_entries : 0.0);
+    printf("lookup %.0f ns, generate_resonance %.0f ns\n", lookup_ns, solve_ns);
+    result_store_close(&store);
+
+    free(image);
+    free(entries);
+    free(records);
+    free(seen);
+    return 0;
+}
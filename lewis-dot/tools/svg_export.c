@@ -0,0 +1,134 @@
+/*
+ * Host-side batch SVG export.
+ *
+ * Solves every composition of a corpus (and --random N more) and renders
+ * each resonance form through svg_writer.c. With an output directory each
+ * form goes to its own file, NNNN_F.svg (composition number, form);
+ * without one the documents are formatted and discarded, which times the
+ * writer alone. --panel adds the VSEPR card. Prints documents written,
+ * bytes, and documents per second for the solver and for the writer.
+ *
+ *   svg_export corpus.txt [outdir] [--panel] [--random N [SEED]]
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/lewis_engine.h"
+#include "../src/lewis_model.h"
+#include "out_sink.h"
+#include "svg_writer.h"
+#include "corpus.h"
+
+static double now_nanos(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static bool discard(void *ctx, const char *data, size_t len)
+{
+    (void)ctx;
+    (void)data;
+    (void)len;
+    return true;
+}
+
+static const char *outdir;
+static uint8_t flags;
+static char buf[1 << 16];
+static unsigned long compositions;
+static unsigned long documents;
+static unsigned long bytes;
+static double solve_nanos;
+static double write_nanos;
+
+static bool write_form(Molecule *mol, uint8_t form)
+{
+    OutSink out;
+    FILE *o = NULL;
+    if (outdir != NULL) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%04lu_%u.svg", outdir, compositions, (unsigned)form);
+        if ((o = fopen(path, "wb")) == NULL) {
+            fprintf(stderr, "cannot open %s\n", path);
+            return false;
+        }
+        out_sink_init_file(&out, o, buf, sizeof(buf));
+    } else {
+        out_sink_init(&out, buf, sizeof(buf), discard, NULL);
+    }
+
+    bool ok = svg_write_form(&out, mol, form, flags) && out_sink_flush(&out);
+    if (o != NULL && fclose(o) != 0) ok = false;
+    bytes += (unsigned long)out.flushed;
+    return ok;
+}
+
+static bool export_molecule(Molecule *mol)
+{
+    compositions++;
+    double t0 = now_nanos();
+    generate_resonance(mol);
+    double t1 = now_nanos();
+    bool ok = true;
+    for (uint8_t f = 0; ok && f < mol->num_res; f++) ok = write_form(mol, f);
+    double t2 = now_nanos();
+
+    solve_nanos += t1 - t0;
+    write_nanos += t2 - t1;
+    documents += mol->num_res;
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    const char *corpus = NULL;
+    unsigned long random_n = 0;
+
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "--random") == 0 && a + 1 < argc) {
+            random_n = strtoul(argv[++a], NULL, 10);
+            if (a + 1 < argc && argv[a + 1][0] != '-') corpus_random_seed((uint32_t)strtoul(argv[++a], NULL, 10));
+        } else if (strcmp(argv[a], "--panel") == 0) {
+            flags |= SVG_VSEPR_PANEL;
+        } else if (corpus == NULL) {
+            corpus = argv[a];
+        } else {
+            outdir = argv[a];
+        }
+    }
+    if (corpus == NULL) {
+        fprintf(stderr, "usage: svg_export corpus.txt [outdir] [--panel] [--random N [SEED]]\n");
+        return 1;
+    }
+
+    FILE *f = fopen(corpus, "r");
+    if (f == NULL) {
+        fprintf(stderr, "cannot open %s\n", corpus);
+        return 1;
+    }
+
+    char line[128];
+    Molecule mol;
+    bool ok = true;
+    while (ok && corpus_next(f, line, sizeof(line), &mol)) ok = export_molecule(&mol);
+    fclose(f);
+    for (unsigned long k = 0; ok && k < random_n; k++) {
+        corpus_random_molecule(&mol);
+        ok = export_molecule(&mol);
+    }
+    if (!ok) {
+        fprintf(stderr, "write failed\n");
+        return 1;
+    }
+
+    printf("compositions %lu, documents %lu, bytes %lu\n", compositions, documents, bytes);
+    printf("solve %.0f compositions/s, svg %.0f documents/s\n",
+           solve_nanos > 0.0 ? compositions * 1e9 / solve_nanos : 0.0,
+           write_nanos > 0.0 ? documents * 1e9 / write_nanos : 0.0);
+    return 0;
+}
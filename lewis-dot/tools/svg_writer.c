@@ -0,0 +1,273 @@
+#include "svg_writer.h"
+
+#include <string.h>
+
+#include "../src/lewis_engine.h"
+#include "../src/occupancy.h"
+
+/* Text baseline below the top of the 8 px calculator font cell. */
+#define SVG_BASELINE 7
+#define SVG_CHAR_W   8
+#define SVG_LINE_H   8
+
+static DisplayList svg_dl;
+
+static void put_attr(OutSink *out, const char *name, int32_t v)
+{
+    out_sink_putc(out, ' ');
+    out_sink_puts(out, name);
+    out_sink_puts(out, "=\"");
+    out_sink_put_int(out, v, 0);
+    out_sink_putc(out, '"');
+}
+
+static void put_escaped(OutSink *out, const char *text, uint8_t len)
+{
+    for (uint8_t i = 0; i < len && text[i] != '\0'; i++) {
+        char c = text[i];
+        if (c == '<') out_sink_puts(out, "&lt;");
+        else if (c == '>') out_sink_puts(out, "&gt;");
+        else if (c == '&') out_sink_puts(out, "&amp;");
+        else out_sink_putc(out, c);
+    }
+}
+
+/* <text> with its top-left corner at (x, y), as safe_print places it. */
+static void put_text(OutSink *out, int x, int y, const char *text, uint8_t len, const char *fill)
+{
+    out_sink_puts(out, "<text");
+    put_attr(out, "x", x);
+    put_attr(out, "y", y + SVG_BASELINE);
+    if (fill != NULL) {
+        out_sink_puts(out, " fill=\"");
+        out_sink_puts(out, fill);
+        out_sink_putc(out, '"');
+    }
+    out_sink_putc(out, '>');
+    put_escaped(out, text, len);
+    out_sink_puts(out, "</text>\n");
+}
+
+static void put_rect(OutSink *out, int x, int y, int w, int h, const char *fill)
+{
+    out_sink_puts(out, "<rect");
+    put_attr(out, "x", x);
+    put_attr(out, "y", y);
+    put_attr(out, "width", w);
+    put_attr(out, "height", h);
+    out_sink_puts(out, " fill=\"");
+    out_sink_puts(out, fill);
+    out_sink_puts(out, "\"/>\n");
+}
+
+static void put_move_line(OutSink *out, int x1, int y1, int x2, int y2)
+{
+    out_sink_putc(out, 'M');
+    out_sink_put_int(out, x1, 0);
+    out_sink_putc(out, ' ');
+    out_sink_put_int(out, y1, 0);
+    out_sink_putc(out, 'L');
+    out_sink_put_int(out, x2, 0);
+    out_sink_putc(out, ' ');
+    out_sink_put_int(out, y2, 0);
+}
+
+/* Word-wrapped text, split the way safe_print_wrapped splits it. */
+static void put_wrapped(OutSink *out, int x, int y, int width, const char *text, uint8_t max_lines)
+{
+    uint8_t max_chars = (uint8_t)(width / SVG_CHAR_W);
+    uint8_t lines = 0;
+    const char *p = text;
+
+    while (*p != '\0' && lines < max_lines && max_chars > 0) {
+        while (*p == ' ') p++;
+        if (*p == '\0') break;
+
+        uint8_t chunk = (uint8_t)strlen(p);
+        if (chunk > max_chars) {
+            chunk = max_chars;
+            while (chunk > 0 && p[chunk] != ' ') chunk--;
+            if (chunk == 0) chunk = max_chars;
+        }
+        uint8_t next = chunk;
+        while (chunk > 0 && p[chunk - 1] == ' ') chunk--;
+
+        put_text(out, x, y + lines * SVG_LINE_H, p, chunk, NULL);
+        lines++;
+        p += next;
+    }
+}
+
+/* The VSEPR card, laid out line for line like draw_vsepr_info_card. */
+static void put_card(OutSink *out, const Molecule *mol, const LewisStructure *ls, const DlBox *b)
+{
+    VseprInfo info;
+    bool has_row = lewis_get_vsepr_info(mol, ls, &info);
+    uint8_t pi_bonds = 0;
+    for (uint8_t k = 0; k < ls->num_bonds; k++) {
+        if (ls->bonds[k].order > 1) pi_bonds = (uint8_t)(pi_bonds + ls->bonds[k].order - 1);
+    }
+
+    out_sink_puts(out, "<rect");
+    put_attr(out, "x", b->x);
+    put_attr(out, "y", b->y);
+    put_attr(out, "width", b->w - 1);
+    put_attr(out, "height", b->h - 1);
+    out_sink_puts(out, " fill=\"#fff\" stroke=\"#000\"/>\n");
+    put_rect(out, b->x + 1, b->y + 1, b->w - 2, 12, "#000");
+    put_text(out, b->x + 4, b->y + 3, "VSEPR", 5, "#fff");
+
+    out_sink_puts(out, "<text");
+    put_attr(out, "x", b->x + 4);
+    put_attr(out, "y", b->y + 16 + SVG_BASELINE);
+    out_sink_puts(out, ">EP:");
+    out_sink_put_int(out, info.valence_pairs, 0);
+    out_sink_puts(out, " BP:");
+    out_sink_put_int(out, info.bond_pairs, 0);
+    out_sink_puts(out, " LP:");
+    out_sink_put_int(out, info.lone_pairs, 0);
+    out_sink_puts(out, "</text>\n<text");
+    put_attr(out, "x", b->x + 4);
+    put_attr(out, "y", b->y + 26 + SVG_BASELINE);
+    out_sink_puts(out, ">Sig:");
+    out_sink_put_int(out, ls->num_bonds, 0);
+    out_sink_puts(out, " Pi:");
+    out_sink_put_int(out, pi_bonds, 0);
+    out_sink_puts(out, "</text>\n");
+
+    int x = b->x + 4;
+    int w = b->w - 8;
+    if (!has_row) {
+        put_rect(out, b->x + 3, b->y + 37, b->w - 6, 10, "#000");
+        put_text(out, b->x + 6, b->y + 38, "No table match", 14, "#fff");
+        put_text(out, x, b->y + 52, "E-Geom: N/A", 11, NULL);
+        put_text(out, x, b->y + 68, "Shape: N/A", 10, NULL);
+        put_text(out, x, b->y + 84, "Hyb: N/A", 8, NULL);
+        put_text(out, x, b->y + 98, "Angle:", 6, NULL);
+        put_wrapped(out, x, b->y + 106, w, "N/A", 2);
+        return;
+    }
+
+    put_text(out, x, b->y + 36, "E-Geom:", 7, NULL);
+    put_wrapped(out, x, b->y + 46, w, info.ep_geometry ? info.ep_geometry : "N/A", 2);
+    put_text(out, x, b->y + 60, "Shape:", 6, NULL);
+    put_wrapped(out, x, b->y + 70, w, info.shape ? info.shape : "N/A", 2);
+
+    out_sink_puts(out, "<text");
+    put_attr(out, "x", x);
+    put_attr(out, "y", b->y + 86 + SVG_BASELINE);
+    out_sink_puts(out, ">Hyb: ");
+    out_sink_puts(out, info.hybridization ? info.hybridization : "N/A");
+    out_sink_puts(out, "</text>\n");
+    put_text(out, x, b->y + 98, "Angle:", 6, NULL);
+    put_wrapped(out, x, b->y + 106, w, info.bond_angle ? info.bond_angle : "N/A", 2);
+}
+
+bool svg_write_display_list(OutSink *out, const Molecule *mol, const LewisStructure *ls, const DisplayList *dl)
+{
+    OutMark start = out_sink_mark(out);
+
+    int min_x = SCR_W;
+    int min_y = SCR_H;
+    int max_x = 0;
+    int max_y = 0;
+    for (uint8_t i = 0; i < dl->count; i++) {
+        const DlBox *b = &dl->prims[i].box;
+        if (b->x < min_x) min_x = b->x;
+        if (b->y < min_y) min_y = b->y;
+        if (b->x + b->w > max_x) max_x = b->x + b->w;
+        if (b->y + b->h > max_y) max_y = b->y + b->h;
+    }
+    if (max_x <= min_x || max_y <= min_y) {
+        min_x = 0;
+        min_y = 0;
+        max_x = SCR_W;
+        max_y = SCR_H;
+    }
+    min_x -= SVG_MARGIN;
+    min_y -= SVG_MARGIN;
+    max_x += SVG_MARGIN;
+    max_y += SVG_MARGIN;
+
+    out_sink_puts(out, "<svg xmlns=\"http://www.w3.org/2000/svg\"");
+    put_attr(out, "width", max_x - min_x);
+    put_attr(out, "height", max_y - min_y);
+    out_sink_puts(out, " viewBox=\"");
+    out_sink_put_int(out, min_x, 0);
+    out_sink_putc(out, ' ');
+    out_sink_put_int(out, min_y, 0);
+    out_sink_putc(out, ' ');
+    out_sink_put_int(out, max_x - min_x, 0);
+    out_sink_putc(out, ' ');
+    out_sink_put_int(out, max_y - min_y, 0);
+    out_sink_puts(out, "\" font-family=\"monospace\" font-size=\"8\">\n");
+    put_rect(out, min_x, min_y, max_x - min_x, max_y - min_y, "#fff");
+
+    /* Bonds first, as one stroked path, so symbol boxes can clear them. */
+    out_sink_puts(out, "<path stroke=\"#000\" fill=\"none\" d=\"");
+    for (uint8_t i = 0; i < dl->count; i++) {
+        const DlPrim *p = &dl->prims[i];
+        if (p->kind != DL_BOND) continue;
+        if (p->order != 2) put_move_line(out, p->x1, p->y1, p->x2, p->y2);
+        if (p->order >= 2) {
+            put_move_line(out, p->x1 + p->ox, p->y1 + p->oy, p->x2 + p->ox, p->y2 + p->oy);
+            put_move_line(out, p->x1 - p->ox, p->y1 - p->oy, p->x2 - p->ox, p->y2 - p->oy);
+        }
+    }
+    out_sink_puts(out, "\"/>\n");
+
+    for (uint8_t i = 0; i < dl->count; i++) {
+        const DlPrim *p = &dl->prims[i];
+        switch (p->kind) {
+        case DL_SYMBOL:
+            put_rect(out, p->box.x, p->box.y, p->box.w, p->box.h, "#fff");
+            put_text(out, p->x1, p->y1, p->text, DL_TEXT_MAX, NULL);
+            break;
+
+        case DL_DOTS:
+            out_sink_puts(out, "<circle");
+            put_attr(out, "cx", p->x1);
+            put_attr(out, "cy", p->y1);
+            put_attr(out, "r", DOT_R);
+            out_sink_puts(out, "/><circle");
+            put_attr(out, "cx", p->x2);
+            put_attr(out, "cy", p->y2);
+            put_attr(out, "r", DOT_R);
+            out_sink_puts(out, "/>\n");
+            break;
+
+        case DL_CHARGE:
+            put_text(out, p->x1, p->y1, p->text, DL_TEXT_MAX, NULL);
+            break;
+
+        case DL_CARD:
+            put_card(out, mol, ls, &p->box);
+            break;
+
+        default:
+            break;
+        }
+    }
+    out_sink_puts(out, "</svg>\n");
+
+    if (out->failed) {
+        out_sink_rollback(out, start);
+        return false;
+    }
+    return true;
+}
+
+bool svg_write_form(OutSink *out, const Molecule *mol, uint8_t form, uint8_t flags)
+{
+    if (form >= mol->num_res) return false;
+
+    LewisStructure ls;
+    molecule_form(mol, form, &ls);
+    display_list_build(mol, &ls, &mol->layout[form], &svg_dl);
+
+    DlBox card;
+    if ((flags & SVG_VSEPR_PANEL) && vsepr_card_place(&svg_dl, false, &card)) {
+        display_list_add_card(&svg_dl, &card);
+    }
+    return svg_write_display_list(out, mol, &ls, &svg_dl);
+}
@@ -0,0 +1,34 @@
+#ifndef SVG_WRITER_H
+#define SVG_WRITER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../src/display_list.h"
+#include "../src/lewis_model.h"
+#include "out_sink.h"
+
+/*
+ * SVG rendering of the Lewis screen's display list, streamed to an
+ * OutSink: bonds (offset strokes for multiple bonds, as draw_lewis draws
+ * them), lone-pair dots, symbols on a cleared box, formal charges and,
+ * when the list holds one, the VSEPR card. Coordinates are the screen
+ * pixels of the layout; the viewBox is cropped to the drawn boxes plus
+ * SVG_MARGIN. Numbers are formatted with integer routines only.
+ */
+#define SVG_MARGIN 4
+
+/* svg_write_form() flags */
+#define SVG_VSEPR_PANEL 0x01  /* place and draw the VSEPR card like the calculator does */
+
+/* One document for an already built display list. */
+bool svg_write_display_list(OutSink *out, const Molecule *mol, const LewisStructure *ls, const DisplayList *dl);
+
+/*
+ * Build the display list of resonance form `form` and write it. Uses a
+ * static display list, so it is not reentrant. On failure the sink is
+ * rolled back to the document start when nothing of it was flushed.
+ */
+bool svg_write_form(OutSink *out, const Molecule *mol, uint8_t form, uint8_t flags);
+
+#endif